@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <tuple>
+#include <random>
+#include <cstdint> // for std::uintptr_t
+#include "physics/ContactTable.h"
+
+/*
+================================
+ContactTable randomized check.
+
+Drives a ContactTable and a std::map through the same random
+insert / find / erase / expire sequence, and compares
+every result. Keys come from a small ID space, so probe runs
+collide, wrap around the end of the array and get erased from
+the middle, and the table grows a few times.
+
+Exits with status 1 on the first disagreement.
+
+Usage: contact-table-check [steps] [seed]
+================================
+*/
+
+/*
+================================
+Model
+
+What ContactTable should hold: each key's Contact
+and whether it was found or inserted this frame.
+================================
+*/
+typedef std::tuple < int, int, int, int, int, int > ModelKey;
+
+struct ModelEntry
+{
+	Contact* ct;
+	bool live;
+};
+
+static ModelKey model_key( const ContactKey& key )
+{
+	return ModelKey( key.a.pid, key.a.cid, key.a.fid, key.b.pid, key.b.cid, key.b.fid );
+}
+
+static ContactKey random_key( std::mt19937& rng, int ids )
+{
+	std::uniform_int_distribution < int > pid( 0, ids - 1 ), small( 0, 3 );
+	ContactKey key;
+	key.a.pid = pid( rng );
+	key.a.cid = small( rng );
+	key.a.fid = small( rng );
+	key.b.pid = pid( rng );
+	key.b.cid = small( rng );
+	key.b.fid = small( rng );
+	return key;
+}
+
+// The table never dereferences its Contacts; any distinct non-null pointer will do.
+static Contact* fake_contact( int i )
+{
+	return (Contact*) (std::uintptr_t) i;
+}
+
+static bool fail( int step, const char* what )
+{
+	printf( "step %d: %s\n", step, what );
+	return false;
+}
+
+/*
+================================
+run
+
+Returns true if the table and the model agreed throughout.
+================================
+*/
+static bool run( int steps, unsigned int seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_int_distribution < int > op( 0, 99 );
+	ContactTable table;
+	std::map < ModelKey, ModelEntry > model;
+	int next_contact = 1;
+
+	for ( int step = 0; step < steps; ++step ) {
+		// Vary the ID space, so the table fills up and drains
+		int ids = 2 + ( step / 5000 ) % 24;
+		ContactKey key = random_key( rng, ids );
+		auto it = model.find( model_key( key ) );
+		int r = op( rng );
+
+		if ( r < 40 ) {
+			Contact* ct = table.find( key );
+			if ( it == model.end() ) {
+				if ( ct ) return fail( step, "find: found a missing key" );
+			}
+			else {
+				if ( ct != it->second.ct ) return fail( step, "find: wrong contact" );
+				it->second.live = true;
+			}
+		}
+		else if ( r < 75 ) {
+			// The key must not be in the table already
+			if ( it != model.end() ) continue;
+			Contact* ct = fake_contact( next_contact++ );
+			table.insert( key, ct );
+			ModelEntry e = { ct, true };
+			model[ model_key( key ) ] = e;
+		}
+		else if ( r < 95 ) {
+			table.erase( key );
+			if ( it != model.end() ) model.erase( it );
+		}
+		else {
+			std::set < Contact* > expired;
+			bool twice = false;
+			table.expire( [&]( Contact* ct ) {
+				if ( ! expired.insert( ct ).second ) twice = true;
+			} );
+			if ( twice ) return fail( step, "expire: visited a contact twice" );
+
+			std::set < Contact* > expected;
+			for ( auto m = model.begin(); m != model.end(); ) {
+				if ( m->second.live ) {
+					m->second.live = false;
+					++m;
+				}
+				else {
+					expected.insert( m->second.ct );
+					m = model.erase( m );
+				}
+			}
+			if ( expired != expected ) return fail( step, "expire: wrong contacts" );
+		}
+
+		if ( table.size() != (int) model.size() ) return fail( step, "wrong size" );
+	}
+
+	// Everything left must still be found
+	for ( auto& m : model ) {
+		ContactKey key;
+		std::tie( key.a.pid, key.a.cid, key.a.fid, key.b.pid, key.b.cid, key.b.fid ) = m.first;
+		if ( table.find( key ) != m.second.ct ) return fail( steps, "final find: wrong contact" );
+	}
+
+	return true;
+}
+
+/*
+================================
+main
+================================
+*/
+int main( int argc, char** argv )
+{
+	int steps = argc > 1 ? atoi( argv[1] ) : 1000000;
+	unsigned int seed = argc > 2 ? atoi( argv[2] ) : 1234;
+
+	if ( ! run( steps, seed ) ) return 1;
+	printf( "ContactTable agrees with std::map over %d steps (seed %u)\n", steps, seed );
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "physics/PhysicsState.h"
+#include "spatial/SIMD.h"
+
+/*
+================================
+Rigid body solver determinism check.
+
+Steps the same stacking scene with one solver thread
+and with several, with and without wide rows, and compares
+the final state of every body bit for bit. The scene has
+one big pyramid (an island with enough rows to be colored
+and solved by every thread at once) and a row of columns
+(small islands, solved side by side).
+
+The scene is run twice: with the frame frozen, and with it
+pinned (free to turn). A pinned frame is in the island with
+every box on it, which then needs more than 64 colors,
+so the last, serial, batch of rows is checked too.
+
+Exits with status 1 if any body differs.
+
+Usage: solver-check [steps] [threads]
+(run from the top directory, for the level files)
+================================
+*/
+
+/*
+================================
+SolverCheckState
+
+A PhysicsState that isn't a singleton.
+================================
+*/
+class SolverCheckState : public PhysicsState
+{
+public:
+	SolverCheckState() {}
+};
+
+/*
+================================
+build
+
+Like PyramidTestState and ColumnTestState, side by side.
+================================
+*/
+static std::vector < Rigid* > build( PhysicsState& ps, bool pinned )
+{
+	const Scalar step = 50.0 * 1.5;
+	const Vec2 g( 0, -0.3 );
+	std::vector < Rigid* > bodies;
+
+	MeshOBJ o_frame;
+	o_frame.load( Path( "level/pong/", "frame.obj" ) );
+	o_frame.setScale( 50 );
+
+	Rigid* frame = ps.createRigid( o_frame );
+	frame->position = Vec2( 0, -600 );
+	frame->linear_enable = false;
+	frame->angular_enable = pinned;
+	frame->mask = 0x1;
+	bodies.push_back( frame );
+
+	MeshOBJ o_rg;
+	o_rg.load( Path( "level/test/", "4gon.obj" ) );
+	o_rg.setScale( 50 );
+
+	auto add = [&]( const Vec2& position ) {
+		Rigid* rg = ps.createRigid( o_rg );
+		rg->position = position;
+		rg->gravity = g;
+		rg->bounce = 0.25;
+		rg->friction = 0.25;
+		rg->mask = 0x1;
+		bodies.push_back( rg );
+	};
+
+	const int x = 10;
+	for ( int j = 0; j < x; ++j ) {
+	for ( int i = 0; i < x-j; ++i ) {
+		Vec2 off = Vec2( j-x+1, 0 ) * step * 0.5;
+		add( Vec2( i, j ) * step + off );
+	}}
+
+	for ( int c = 0; c < 8; ++c ) {
+		Scalar cx = ( c < 4 ? -1 : 1 ) * ( 450 + 150 * ( c % 4 ) );
+		for ( int j = 0; j < 6; ++j ) {
+			add( Vec2( cx, j * step ) );
+		}
+	}
+
+	return bodies;
+}
+
+/*
+================================
+simulate
+
+Returns the final position and velocity of every body.
+================================
+*/
+static std::vector < Scalar > simulate( int steps, bool pinned, int threads, bool wide )
+{
+	SolverCheckState ps;
+	ps.init( 0 );
+	ps.setSolverThreads( threads );
+	ps.setWideRows( wide );
+	std::vector < Rigid* > bodies = build( ps, pinned );
+
+	for ( int i = 0; i < steps; ++i ) ps.update( 0 );
+
+	std::vector < Scalar > state;
+	for ( Rigid* rg : bodies ) {
+		Vec3 p = rg->getPositionState();
+		Vec3 v = rg->getVelocityState();
+		Scalar s[6] = { p.x, p.y, p.z, v.x, v.y, v.z };
+		state.insert( state.end(), s, s + 6 );
+	}
+
+	ps.cleanup();
+	return state;
+}
+
+/*
+================================
+main
+================================
+*/
+int main( int argc, char** argv )
+{
+	int steps = argc > 1 ? atoi( argv[1] ) : 300;
+	int threads = argc > 2 ? atoi( argv[2] ) : std::max( 4u, std::thread::hardware_concurrency() );
+
+	// Wide rows are only there with SIMD instructions
+	int wides = SPATIAL_SIMD_LANES > 1 ? 2 : 1;
+
+	for ( int pinned = 0; pinned < 2; ++pinned ) {
+		const char* frame = pinned ? "pinned" : "frozen";
+		std::vector < Scalar > one = simulate( steps, pinned, 1, false );
+
+		for ( int wide = 0; wide < wides; ++wide ) {
+		for ( int t : { 1, threads } ) {
+			if ( t == 1 && ! wide ) continue;
+			std::vector < Scalar > other = simulate( steps, pinned, t, wide );
+
+			int n = one.size() / 6;
+			for ( int i = 0; i < n; ++i ) {
+				if ( memcmp( &one[ i*6 ], &other[ i*6 ], 6 * sizeof( Scalar ) ) != 0 ) {
+					printf( "body %d differs after %d steps, %s frame (1 thread vs %d%s)\n",
+						i, steps, frame, t, wide ? " with wide rows" : "" );
+					return 1;
+				}
+			}
+
+			printf( "%d bodies identical after %d steps, %s frame (1 thread vs %d%s)\n",
+				n, steps, frame, t, wide ? " with wide rows" : "" );
+		}}
+	}
+
+	return 0;
+}
@@ -0,0 +1,481 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <new>
+#include <cstdint> // for std::uintptr_t
+#include "spatial/AABB.h"
+#include "spatial/AABBArray.h"
+#include "spatial/RD_BruteForce.h"
+#include "spatial/RD_DynamicTree.h"
+#include "spatial/RD_SweepAndPrune.h"
+#include "spatial/RD_Quadtree.h"
+#include "spatial/PD_BruteForce.h"
+#include "spatial/PD_HashGrid.h"
+
+/*
+================================
+Spatial structure benchmark.
+
+Drives every RegionData and PointData implementation
+through build / query / move cycles on synthetic scenes,
+at 100, 1k, 10k and 100k entries.
+
+For each structure and size, reports:
+	build	time to insert every entry
+	ns/q	time per query (or per entry, for all-pairs structures)
+	frame	time to move every entry a little and find all pairs again
+	pairs	overlapping pairs found (should agree between structures)
+	mem	heap bytes held by the structure after the build
+
+Quadratic structures are skipped above 10k entries.
+
+Usage: spatial-bench [max entries]
+================================
+*/
+
+/*
+================================
+Heap accounting
+
+Every allocation carries its size, so the bytes in use
+can be read before and after a build.
+================================
+*/
+static long long heap_live = 0;
+
+void* operator new( std::size_t size )
+{
+	std::size_t* p = (std::size_t*) std::malloc( size + 16 );
+	if ( !p ) throw std::bad_alloc();
+	*p = size;
+	heap_live += size;
+	return (char*) p + 16;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+	if ( !ptr ) return;
+	// (through an integer, so the compiler doesn't see an out-of-bounds access)
+	std::size_t* p = (std::size_t*) ( (std::uintptr_t) ptr - 16 );
+	heap_live -= *p;
+	std::free( p );
+}
+
+/*
+================================
+Timing
+================================
+*/
+typedef std::chrono::steady_clock Clock;
+
+static double ms_since( Clock::time_point t0 )
+{
+	return std::chrono::duration < double, std::milli >( Clock::now() - t0 ).count();
+}
+
+/*
+================================
+Scenes
+
+Box sizes stay the same at every scale;
+the world grows so the density stays the same.
+================================
+*/
+enum SceneType
+	{ SC_UNIFORM, SC_CLUSTERED, SC_HUGE, SC_STACKS };
+
+static const char* scene_names[] =
+	{ "uniform", "clustered", "huge+small", "stacks" };
+
+struct Scene
+{
+	std::vector < AABB > boxes;
+	std::vector < Vec2 > velocities;
+};
+
+static AABB box_at( Vec2 center, Scalar w, Scalar h )
+{
+	Vec2 half( w * 0.5, h * 0.5 );
+	return AABB( center - half, center + half );
+}
+
+static Scene make_scene( SceneType type, int n, unsigned int seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution < Scalar > unit( 0, 1 );
+
+	Scalar side = std::sqrt( (Scalar) n ) * 40;
+
+	Scene s;
+	switch ( type )
+	{
+	case SC_UNIFORM:
+		for ( int i = 0; i < n; ++i ) {
+			Vec2 c( unit( rng ) * side, unit( rng ) * side );
+			s.boxes.push_back( box_at( c, 5 + unit( rng ) * 15, 5 + unit( rng ) * 15 ) );
+		}
+		break;
+
+	case SC_CLUSTERED: {
+		// Most entries in a few dense clusters
+		int k = std::max( 1, n / 500 );
+		std::vector < Vec2 > centers;
+		for ( int i = 0; i < k; ++i ) {
+			centers.push_back( Vec2( unit( rng ) * side, unit( rng ) * side ) );
+		}
+		std::normal_distribution < Scalar > spread( 0, 80 );
+		for ( int i = 0; i < n; ++i ) {
+			Vec2 c = centers[ i % k ] + Vec2( spread( rng ), spread( rng ) );
+			s.boxes.push_back( box_at( c, 5 + unit( rng ) * 15, 5 + unit( rng ) * 15 ) );
+		}
+	}
+	break;
+
+	case SC_HUGE:
+		// One box covering everything, then small ones
+		s.boxes.push_back( AABB( Vec2( 0 ), Vec2( side ) ) );
+		for ( int i = 1; i < n; ++i ) {
+			Vec2 c( unit( rng ) * side, unit( rng ) * side );
+			s.boxes.push_back( box_at( c, 2 + unit( rng ) * 4, 2 + unit( rng ) * 4 ) );
+		}
+		break;
+
+	case SC_STACKS: {
+		// Columns of touching boxes; each column sways as one,
+		// the other way from its neighbors
+		int height = std::max( 1, (int) std::sqrt( (Scalar) n ) );
+		for ( int i = 0; i < n; ++i ) {
+			int column = i / height;
+			int row = i % height;
+			Vec2 c( column * 60.0, row * 20.0 + 10 );
+			s.boxes.push_back( box_at( c, 40, 20 ) );
+			s.velocities.push_back( Vec2( ( column % 2 ) ? 0.5 : -0.5, 0 ) );
+		}
+	}
+	break;
+	}
+
+	if ( type != SC_STACKS ) {
+		for ( int i = 0; i < n; ++i ) {
+			s.velocities.push_back( Vec2( unit( rng ) - 0.5, unit( rng ) - 0.5 ) * 2 );
+		}
+	}
+	if ( type == SC_HUGE ) s.velocities[0] = Vec2( 0 );
+
+	return s;
+}
+
+static void move_scene( Scene& s )
+{
+	int n = s.boxes.size();
+	for ( int i = 0; i < n; ++i ) {
+		s.boxes[i].min += s.velocities[i];
+		s.boxes[i].max += s.velocities[i];
+	}
+}
+
+/*
+================================
+Results
+================================
+*/
+struct Result
+{
+	double build_ms;
+	double query_ns;
+	double frame_ms;
+	long long pairs;
+	long long mem;
+};
+
+static void print_header()
+{
+	printf( "%-11s %-17s %7s %10s %9s %10s %11s %10s\n",
+		"scene", "structure", "n", "build ms", "ns/q", "frame ms", "pairs", "mem KB" );
+}
+
+static void print_result( SceneType type, const char* name, int n, const Result& r )
+{
+	printf( "%-11s %-17s %7d %10.3f %9.1f %10.3f %11lld %10.1f\n",
+		scene_names[ type ], name, n,
+		r.build_ms, r.query_ns, r.frame_ms, r.pairs, r.mem / 1024.0 );
+	fflush( stdout );
+}
+
+static void print_skipped( SceneType type, const char* name, int n )
+{
+	printf( "%-11s %-17s %7d %10s\n", scene_names[ type ], name, n, "(skipped)" );
+}
+
+static const int FRAMES = 10;
+
+/*
+================================
+Rebuilt structures (cleared and refilled every frame):
+RD_BruteForce, RD_Quadtree
+
+Pairs come from querying every box; each pair is seen twice,
+and every box sees itself.
+================================
+*/
+template < typename RD >
+static long long rd_count_pairs( const RD& rd, const Scene& s )
+{
+	long long hits = 0;
+	for ( const AABB& box : s.boxes ) {
+		rd.query( box, [&hits]( int ) { ++hits; } );
+	}
+	return ( hits - (long long) s.boxes.size() ) / 2;
+}
+
+static AABB bounds_of( const Scene& s )
+{
+	AABB bounds = s.boxes[0];
+	for ( const AABB& box : s.boxes ) bounds += box;
+	return bounds;
+}
+
+static void rd_fill( RD_BruteForce < int >& rd, const Scene& s )
+{
+	rd.clear();
+	int n = s.boxes.size();
+	for ( int i = 0; i < n; ++i ) rd.insert( s.boxes[i], i );
+}
+
+static void rd_fill( RD_Quadtree < int >& rd, const Scene& s )
+{
+	rd.clear( bounds_of( s ) );
+	int n = s.boxes.size();
+	for ( int i = 0; i < n; ++i ) rd.insert( s.boxes[i], i );
+}
+
+template < typename RD >
+static Result bench_rebuilt( Scene s )
+{
+	Result r;
+	long long mem0 = heap_live;
+	RD* rd = new RD();
+
+	Clock::time_point t0 = Clock::now();
+	rd_fill( *rd, s );
+	r.build_ms = ms_since( t0 );
+	r.mem = heap_live - mem0;
+
+	t0 = Clock::now();
+	r.pairs = rd_count_pairs( *rd, s );
+	r.query_ns = ms_since( t0 ) * 1e6 / s.boxes.size();
+
+	t0 = Clock::now();
+	for ( int f = 0; f < FRAMES; ++f ) {
+		move_scene( s );
+		rd_fill( *rd, s );
+		rd_count_pairs( *rd, s );
+	}
+	r.frame_ms = ms_since( t0 ) / FRAMES;
+
+	delete rd;
+	return r;
+}
+
+/*
+================================
+RD_DynamicTree (persistent, moved every frame)
+================================
+*/
+static Result bench_tree( Scene s )
+{
+	Result r;
+	long long mem0 = heap_live;
+	RD_DynamicTree < int >* rd = new RD_DynamicTree < int >();
+	int n = s.boxes.size();
+	std::vector < int > proxies( n );
+
+	Clock::time_point t0 = Clock::now();
+	for ( int i = 0; i < n; ++i ) proxies[i] = rd->insert( s.boxes[i], i );
+	r.build_ms = ms_since( t0 );
+	r.mem = heap_live - mem0;
+
+	// The tree reports fat boxes; check the real ones
+	long long hits = 0;
+	t0 = Clock::now();
+	for ( int i = 0; i < n; ++i ) {
+		const AABB& box = s.boxes[i];
+		rd->query( box, [&]( int j ) { if ( box.intersects( s.boxes[j] ) ) ++hits; } );
+	}
+	r.query_ns = ms_since( t0 ) * 1e6 / n;
+	r.pairs = ( hits - n ) / 2;
+
+	t0 = Clock::now();
+	for ( int f = 0; f < FRAMES; ++f ) {
+		move_scene( s );
+		for ( int i = 0; i < n; ++i ) rd->move( proxies[i], s.boxes[i] );
+		for ( int i = 0; i < n; ++i ) {
+			const AABB& box = s.boxes[i];
+			rd->query( box, [&]( int j ) { if ( box.intersects( s.boxes[j] ) ) ++hits; } );
+		}
+	}
+	r.frame_ms = ms_since( t0 ) / FRAMES;
+
+	delete rd;
+	return r;
+}
+
+/*
+================================
+RD_SweepAndPrune (persistent, moved every frame)
+
+Frame pairs come from the pair set (and its events), not from queries.
+================================
+*/
+static Result bench_sap( Scene s )
+{
+	Result r;
+	long long mem0 = heap_live;
+	RD_SweepAndPrune < int >* rd = new RD_SweepAndPrune < int >();
+	int n = s.boxes.size();
+	std::vector < int > proxies( n );
+	std::vector < RD_SweepAndPrune < int >::Pair > added, removed;
+
+	Clock::time_point t0 = Clock::now();
+	for ( int i = 0; i < n; ++i ) proxies[i] = rd->insert( s.boxes[i], i );
+	rd->flush();
+	r.build_ms = ms_since( t0 );
+	r.mem = heap_live - mem0;
+	rd->events( added, removed );
+
+	t0 = Clock::now();
+	rd_count_pairs( *rd, s );
+	r.query_ns = ms_since( t0 ) * 1e6 / n;
+
+	long long pairs = 0;
+	rd->pairs( [&pairs]( int, int ) { ++pairs; } );
+	r.pairs = pairs;
+
+	t0 = Clock::now();
+	for ( int f = 0; f < FRAMES; ++f ) {
+		move_scene( s );
+		for ( int i = 0; i < n; ++i ) rd->move( proxies[i], s.boxes[i] );
+		rd->events( added, removed );
+		rd->pairs( [&pairs]( int, int ) { ++pairs; } );
+	}
+	r.frame_ms = ms_since( t0 ) / FRAMES;
+
+	delete rd;
+	return r;
+}
+
+/*
+================================
+AABBArray (SIMD all-pairs, rebuilt every frame)
+================================
+*/
+static Result bench_array( Scene s )
+{
+	Result r;
+	long long mem0 = heap_live;
+	AABBArray* boxes = new AABBArray();
+
+	Clock::time_point t0 = Clock::now();
+	for ( const AABB& box : s.boxes ) boxes->push_back( box );
+	r.build_ms = ms_since( t0 );
+	r.mem = heap_live - mem0;
+
+	long long pairs = 0;
+	t0 = Clock::now();
+	boxes->find_all_pairs( [&pairs]( int, int ) { ++pairs; } );
+	r.query_ns = ms_since( t0 ) * 1e6 / s.boxes.size();
+	r.pairs = pairs;
+
+	t0 = Clock::now();
+	for ( int f = 0; f < FRAMES; ++f ) {
+		move_scene( s );
+		boxes->clear();
+		for ( const AABB& box : s.boxes ) boxes->push_back( box );
+		boxes->find_all_pairs( [&pairs]( int, int ) { ++pairs; } );
+	}
+	r.frame_ms = ms_since( t0 ) / FRAMES;
+
+	delete boxes;
+	return r;
+}
+
+/*
+================================
+PointData: PD_BruteForce, PD_HashGrid
+
+Points are the box centers; every point queries
+a 64x64 box around itself. "pairs" counts the hits.
+================================
+*/
+template < typename PD >
+static Result bench_points( Scene s )
+{
+	Result r;
+	long long mem0 = heap_live;
+	PD* pd = new PD();
+	int n = s.boxes.size();
+
+	Clock::time_point t0 = Clock::now();
+	for ( int i = 0; i < n; ++i ) pd->insert( s.boxes[i].center(), i );
+	r.build_ms = ms_since( t0 );
+	r.mem = heap_live - mem0;
+
+	long long hits = 0;
+	t0 = Clock::now();
+	for ( int i = 0; i < n; ++i ) {
+		pd->query( box_at( s.boxes[i].center(), 64, 64 ), [&hits]( int ) { ++hits; } );
+	}
+	r.query_ns = ms_since( t0 ) * 1e6 / n;
+	r.pairs = hits;
+
+	t0 = Clock::now();
+	for ( int f = 0; f < FRAMES; ++f ) {
+		move_scene( s );
+		pd->clear();
+		for ( int i = 0; i < n; ++i ) pd->insert( s.boxes[i].center(), i );
+		for ( int i = 0; i < n; ++i ) {
+			pd->query( box_at( s.boxes[i].center(), 64, 64 ), [&hits]( int ) { ++hits; } );
+		}
+	}
+	r.frame_ms = ms_since( t0 ) / FRAMES;
+
+	delete pd;
+	return r;
+}
+
+/*
+================================
+main
+================================
+*/
+int main( int argc, char** argv )
+{
+	int max_n = argc > 1 ? atoi( argv[1] ) : 100000;
+	const int QUADRATIC_MAX = 10000;
+
+	print_header();
+	for ( int t = SC_UNIFORM; t <= SC_STACKS; ++t ) {
+		SceneType type = (SceneType) t;
+		for ( int n = 100; n <= max_n; n *= 10 ) {
+			Scene s = make_scene( type, n, 1234 + n );
+			bool quadratic = ( n <= QUADRATIC_MAX );
+
+			if ( quadratic ) print_result( type, "RD_BruteForce", n, bench_rebuilt < RD_BruteForce < int > >( s ) );
+			else print_skipped( type, "RD_BruteForce", n );
+			if ( quadratic ) print_result( type, "AABBArray", n, bench_array( s ) );
+			else print_skipped( type, "AABBArray", n );
+			print_result( type, "RD_DynamicTree", n, bench_tree( s ) );
+			print_result( type, "RD_SweepAndPrune", n, bench_sap( s ) );
+			print_result( type, "RD_Quadtree", n, bench_rebuilt < RD_Quadtree < int > >( s ) );
+
+			if ( quadratic ) print_result( type, "PD_BruteForce", n, bench_points < PD_BruteForce < int > >( s ) );
+			else print_skipped( type, "PD_BruteForce", n );
+			print_result( type, "PD_HashGrid", n, bench_points < PD_HashGrid < int > >( s ) );
+		}
+		printf( "\n" );
+	}
+
+	return 0;
+}
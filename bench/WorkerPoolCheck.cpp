@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <random>
+#include <vector>
+#include "common/WorkerPool.h"
+
+/*
+================================
+WorkerPool randomized check.
+
+Runs random loops on a pool that is resized between runs,
+and checks that every index runs exactly once, on a valid worker,
+and that no call is still running when run returns.
+Also runs barrier loops ( run( size(), f ) with a SpinBarrier ).
+
+Exits with status 1 on the first disagreement.
+
+Usage: worker-pool-check [rounds] [seed]
+================================
+*/
+
+static bool fail( int round, const char* what )
+{
+	printf( "round %d: %s\n", round, what );
+	return false;
+}
+
+/*
+================================
+run
+
+Returns true if every loop ran correctly.
+================================
+*/
+static bool run( int rounds, unsigned int seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_int_distribution < int > size_of( 1, 8 ), n_of( 0, 200 ), runs_of( 1, 4 );
+	WorkerPool pool;
+
+	for ( int round = 0; round < rounds; ++round ) {
+		// Resizing restarts the threads between runs
+		pool.resize( size_of( rng ) );
+		int size = pool.size();
+
+		int runs = runs_of( rng );
+		for ( int r = 0; r < runs; ++r ) {
+			int n = n_of( rng );
+			std::vector < std::atomic < int > > calls( n );
+			for ( auto& c : calls ) c = 0;
+			std::atomic < int > in_flight( 0 );
+			std::atomic < bool > bad_worker( false );
+
+			pool.run( n, [&]( int i, int worker ) {
+				++in_flight;
+				if ( worker < 0 || worker >= size ) bad_worker = true;
+				// Give the other workers time to show up
+				for ( int k = 0; k < ( i % 7 ) * 50; ++k ) std::this_thread::yield();
+				++calls[i];
+				--in_flight;
+			} );
+
+			if ( in_flight != 0 ) return fail( round, "run returned while a call was running" );
+			if ( bad_worker ) return fail( round, "worker out of range" );
+			for ( int i = 0; i < n; ++i ) {
+				if ( calls[i] != 1 ) return fail( round, "index not run exactly once" );
+			}
+		}
+
+		// Every worker at once, waiting for each other twice
+		SpinBarrier barrier( size );
+		std::vector < std::atomic < int > > phase( size );
+		for ( auto& p : phase ) p = 0;
+		std::atomic < bool > early( false );
+
+		pool.run( size, [&]( int t, int ) {
+			phase[t] = 1;
+			barrier.wait();
+			for ( int u = 0; u < size; ++u ) if ( phase[u] < 1 ) early = true;
+			barrier.wait();
+			phase[t] = 2;
+		} );
+
+		if ( early ) return fail( round, "barrier let a thread through early" );
+		for ( int t = 0; t < size; ++t ) {
+			if ( phase[t] != 2 ) return fail( round, "barrier loop didn't finish" );
+		}
+	}
+
+	return true;
+}
+
+/*
+================================
+main
+================================
+*/
+int main( int argc, char** argv )
+{
+	int rounds = argc > 1 ? atoi( argv[1] ) : 300;
+	unsigned int seed = argc > 2 ? atoi( argv[2] ) : 1234;
+
+	if ( ! run( rounds, seed ) ) return 1;
+	printf( "WorkerPool ran every loop correctly over %d rounds (seed %u)\n", rounds, seed );
+	return 0;
+}
@@ -0,0 +1,148 @@
+#include "WorkerPool.h"
+
+/*
+================================
+WorkerPool::WorkerPool
+
+Starts with no worker threads (loops run on the caller).
+================================
+*/
+WorkerPool::WorkerPool() :
+	generation( 0 ),
+	busy( 0 ),
+	stopping( false ),
+	body( 0 ),
+	count( 0 ),
+	next( 0 )
+{
+
+}
+
+/*
+================================
+WorkerPool::~WorkerPool
+================================
+*/
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+/*
+================================
+WorkerPool::resize
+================================
+*/
+void WorkerPool::resize( int size )
+{
+	if ( size < 1 ) size = 1;
+	if ( size == this->size() ) return;
+
+	stop();
+
+	// New threads only wait for loops that start after this
+	int seen;
+	{
+		std::lock_guard < std::mutex > lock( mutex );
+		seen = generation;
+	}
+	for ( int i = 1; i < size; ++i ) {
+		threads.push_back( std::thread( &WorkerPool::work, this, i, seen ) );
+	}
+}
+
+/*
+================================
+WorkerPool::stop
+
+Joins all worker threads.
+================================
+*/
+void WorkerPool::stop()
+{
+	{
+		std::lock_guard < std::mutex > lock( mutex );
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for ( std::thread& t : threads ) t.join();
+	threads.clear();
+
+	stopping = false;
+}
+
+/*
+================================
+WorkerPool::run
+================================
+*/
+void WorkerPool::run( int n, const std::function < void ( int, int ) >& f )
+{
+	// Not worth waking anyone up
+	if ( threads.empty() || n <= 1 ) {
+		for ( int i = 0; i < n; ++i ) f( i, 0 );
+		return;
+	}
+
+	{
+		std::lock_guard < std::mutex > lock( mutex );
+		body = &f;
+		count = n;
+		next = 0;
+		busy = threads.size();
+		++generation;
+	}
+	wake.notify_all();
+
+	loop( 0 );
+
+	std::unique_lock < std::mutex > lock( mutex );
+	done.wait( lock, [this]() { return busy == 0; } );
+	body = 0;
+}
+
+/*
+================================
+WorkerPool::work
+
+Worker thread body: runs its part of each loop until stopped.
+
+seen is the generation of the last loop before this thread started.
+================================
+*/
+void WorkerPool::work( int worker, int seen )
+{
+	for ( ;; ) {
+		{
+			std::unique_lock < std::mutex > lock( mutex );
+			wake.wait( lock, [&]() { return stopping || generation != seen; } );
+			if ( stopping ) return;
+			seen = generation;
+		}
+
+		loop( worker );
+
+		{
+			std::lock_guard < std::mutex > lock( mutex );
+			--busy;
+		}
+		done.notify_one();
+	}
+}
+
+/*
+================================
+WorkerPool::loop
+
+Runs loop indices until there are none left.
+================================
+*/
+void WorkerPool::loop( int worker )
+{
+	for ( ;; ) {
+		int i = next++;
+		if ( i >= count ) return;
+		(*body)( i, worker );
+	}
+}
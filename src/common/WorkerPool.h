@@ -0,0 +1,94 @@
+#ifndef COMMON_WORKER_POOL_H
+#define COMMON_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+================================
+A fixed set of worker threads for parallel loops.
+
+run( n, f ) calls f( i, worker ) once for each i in [ 0, n ),
+and returns when all calls have returned. Indices are handed out
+in ascending order to whichever worker asks next, so callers
+should put their most expensive work at the lowest indices.
+
+worker is in [ 0, size() ) and names the calling thread
+(worker 0 is the thread that called run),
+so callers can keep scratch space per worker.
+
+run( size(), f ) runs every index at once, each on its own thread
+(no thread can take a second index before the others are taken),
+so the calls may wait on each other with a SpinBarrier.
+================================
+*/
+class WorkerPool
+{
+public:
+	WorkerPool();
+	WorkerPool( const WorkerPool& ) = delete;
+	WorkerPool& operator = ( const WorkerPool& ) = delete;
+	~WorkerPool();
+
+	// Number of threads running each loop (including the caller)
+	void resize( int size );
+	int size() const { return threads.size() + 1; }
+
+	void run( int n, const std::function < void ( int, int ) >& f );
+
+private:
+	void stop();
+	void work( int worker, int seen );
+	void loop( int worker );
+
+private: // Members
+	std::vector < std::thread > threads;
+
+	std::mutex mutex;
+	std::condition_variable wake; // a new loop started (or stopping)
+	std::condition_variable done; // a worker finished its part of the loop
+	int generation; // of the current loop
+	int busy; // workers still in the current loop
+	bool stopping;
+
+	// The current loop
+	const std::function < void ( int, int ) >* body;
+	int count;
+	std::atomic < int > next;
+};
+
+/*
+================================
+Makes the specified number of threads wait for each other.
+
+Spins (yielding) instead of sleeping, for
+the short steps of a parallel loop (see WorkerPool).
+================================
+*/
+class SpinBarrier
+{
+public:
+	explicit SpinBarrier( int count ) : count( count ), waiting( 0 ), generation( 0 ) {}
+
+	void wait() {
+		int seen = generation;
+		if ( ++waiting == count ) {
+			waiting = 0;
+			++generation;
+		}
+		else {
+			while ( generation == seen ) std::this_thread::yield();
+		}
+	}
+
+private: // Members
+	int count;
+	std::atomic < int > waiting;
+	std::atomic < int > generation;
+};
+
+#endif
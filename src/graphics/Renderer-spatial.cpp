@@ -25,7 +25,7 @@ void Renderer::drawAABB( const AABB& box )
 Renderer::drawConvex
 ================================
 */
-void Renderer::drawConvex( const Convex& pg )
+void Renderer::drawConvex( const ConvexView& pg )
 {
 	int n = pg.points.size();
 
@@ -14,7 +14,7 @@ Forward declarations
 
 // Spatial
 struct AABB;
-struct Convex;
+struct ConvexView;
 
 // Physics
 class Euler;
@@ -54,7 +54,7 @@ public: // Misc
 
 public: // Spatial
 	void drawAABB( const AABB& box );
-	void drawConvex( const Convex& pg );
+	void drawConvex( const ConvexView& pg );
 
 public: // Physics
 	void drawEuler( const Euler& eu );
@@ -32,4 +32,38 @@ const Scalar PHYSICS_CONTACT_VELOCITY_THRESHOLD = 2.0;
 const Scalar PHYSICS_CONTACT_SLOP = 0.1;
 const Scalar PHYSICS_CONTACT_BIAS = 0.1;
 
+// Broad-phase cell size for Euler particles
+const Scalar PHYSICS_EULER_GRID_CELL = 64.0;
+
+// Cell size of the Verlet particle index (see nearestVerlet)
+const Scalar PHYSICS_VERLET_GRID_CELL = 32.0;
+
+// A shape pair whose relative transform changed by less than this
+// since its last full narrow phase only has its contacts refreshed
+const Scalar PHYSICS_MANIFOLD_LINEAR_TOLERANCE = 0.05;
+const Scalar PHYSICS_MANIFOLD_ANGULAR_TOLERANCE = 0.001;
+
+// Most contacts kept per shape pair (at most 8, see PhysicsState::Manifold)
+const int PHYSICS_MANIFOLD_POINTS = 2;
+
+// Caltrop hits within this depth (or spread) of each other
+// are a tie, and contact reduction keeps the one it kept before
+const Scalar PHYSICS_MANIFOLD_REDUCTION_TOLERANCE = 0.05;
+
+// Island solvers stop once an iteration changes every
+// constraint by less than this (but run at least the minimum):
+// Rigid: the change in lambda; Verlet: the stretch ratio corrected
+const Scalar PHYSICS_RIGID_SOLVER_TOLERANCE = 0.001;
+const int PHYSICS_RIGID_SOLVER_MIN_ITERATIONS = 2;
+const Scalar PHYSICS_VERLET_SOLVER_TOLERANCE = 0.001;
+const int PHYSICS_VERLET_SOLVER_MIN_ITERATIONS = 1;
+
+// Rigid islands with at least this many constraints
+// are graph-colored and solved by every solver thread
+const int PHYSICS_COLORED_ISLAND_ROWS = 128;
+
+// Added to the bounding circle of each Rigid body shape,
+// so rounding in the world transform never makes it too small
+const Scalar PHYSICS_BOUNDING_CIRCLE_SLOP = 0.01;
+
 #endif
@@ -4,15 +4,10 @@
 #include "Friction.h"
 #include "PhysicsState.h"
 
-bool operator == ( const FeatureKey& fk1, const FeatureKey& fk2 ) {
+bool operator == ( const ShapePairKey& sk1, const ShapePairKey& sk2 ) {
 	return
-		fk1.pid == fk2.pid &&
-		fk1.cid == fk2.cid &&
-		fk1.fid == fk2.fid;
-}
-
-bool operator == ( const ContactKey& ck1, const ContactKey& ck2 ) {
-	return (ck1.a == ck2.a) && (ck1.b == ck2.b);
+		sk1.pid_a == sk2.pid_a && sk1.cid_a == sk2.cid_a &&
+		sk1.pid_b == sk2.pid_b && sk1.cid_b == sk2.cid_b;
 }
 
 /*
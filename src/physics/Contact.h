@@ -2,51 +2,38 @@
 #define PHYSICS_CONTACT_H
 
 #include "Constraint.h" // superclass Constraint
-#include <string> // TODO: see std::hash < ContactKey >
+#include "ContactKey.h"
+#include <functional> // for std::hash < ShapePairKey >
 
 class Friction;
 
 /*
 ================================
-A key that uniquely identifies a Rigid body feature.
-================================
-*/
-struct FeatureKey
-{
-public:
-	int pid; // global ID of the Rigid body in the physics engine
-	int cid; // index of the Convex shape in the Rigid body
-	int fid; // index of the feature in the Convex shape (a vertex or an edge)
-
-	friend bool operator == ( const FeatureKey& fk1, const FeatureKey& fk2 );
-};
+A key that uniquely identifies a pair of Rigid body shapes
+(the first is the SAT reference polygon).
 
-/*
-================================
-A key that uniquely identifies a Contact between two Rigid body features.
-
-Used to match new contacts to old contacts.
+Used to remember per-pair narrow-phase state between frames.
 ================================
 */
-struct ContactKey
+struct ShapePairKey
 {
 public:
-	FeatureKey a; // the reference feature (an edge)
-	FeatureKey b; // the incident feature (a vertex)
+	int pid_a, cid_a;
+	int pid_b, cid_b;
 
-	// For std::unordered_map < ContactKey, Contact* >
-	friend bool operator == ( const ContactKey& ck1, const ContactKey& ck2 );
+	friend bool operator == ( const ShapePairKey& sk1, const ShapePairKey& sk2 );
 };
 
-// For std::unordered_map < ContactKey, Contact* >
+// For std::unordered_map < ShapePairKey, ... >
 namespace std {
 	template <>
-	struct hash < ContactKey >
+	struct hash < ShapePairKey >
 	{
-		size_t operator () ( const ContactKey& x ) const {
-			// TODO: Not sure if this is standard user-type hashing procedure.
-			string s( (char*) &x, sizeof( ContactKey ) );
-			return hash < string > () ( s );
+		size_t operator () ( const ShapePairKey& x ) const {
+			size_t h = (size_t) x.pid_a * 73856093u;
+			h ^= (size_t) x.pid_b * 19349663u;
+			h ^= (size_t) ( x.cid_a * 31 + x.cid_b ) * 83492791u;
+			return h;
 		}
 	};
 }
@@ -102,9 +89,6 @@ public: // Members
 	// This Contact's associated Friction constraint. May be NULL.
 	Friction* ft;
 
-private: // Members
-	bool expired;
-
 	friend class PhysicsState;
 };
 
@@ -0,0 +1,12 @@
+#include "ContactKey.h"
+
+bool operator == ( const FeatureKey& fk1, const FeatureKey& fk2 ) {
+	return
+		fk1.pid == fk2.pid &&
+		fk1.cid == fk2.cid &&
+		fk1.fid == fk2.fid;
+}
+
+bool operator == ( const ContactKey& ck1, const ContactKey& ck2 ) {
+	return (ck1.a == ck2.a) && (ck1.b == ck2.b);
+}
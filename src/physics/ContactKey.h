@@ -0,0 +1,36 @@
+#ifndef PHYSICS_CONTACT_KEY_H
+#define PHYSICS_CONTACT_KEY_H
+
+/*
+================================
+A key that uniquely identifies a Rigid body feature.
+================================
+*/
+struct FeatureKey
+{
+public:
+	int pid; // global ID of the Rigid body in the physics engine
+	int cid; // index of the Convex shape in the Rigid body
+	int fid; // index of the feature in the Convex shape (a vertex or an edge)
+
+	friend bool operator == ( const FeatureKey& fk1, const FeatureKey& fk2 );
+};
+
+/*
+================================
+A key that uniquely identifies a Contact between two Rigid body features.
+
+Used to match new contacts to old contacts.
+================================
+*/
+struct ContactKey
+{
+public:
+	FeatureKey a; // the reference feature (an edge)
+	FeatureKey b; // the incident feature (a vertex)
+
+	// For ContactTable
+	friend bool operator == ( const ContactKey& ck1, const ContactKey& ck2 );
+};
+
+#endif
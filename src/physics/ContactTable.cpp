@@ -0,0 +1,152 @@
+#include "ContactTable.h"
+
+/*
+================================
+ContactTable::ContactTable
+================================
+*/
+ContactTable::ContactTable() :
+	n( 0 ),
+	frame( 0 )
+{
+	Entry empty;
+	empty.ct = 0;
+	empty.frame = 0;
+	entries.assign( 64, empty );
+}
+
+/*
+================================
+ContactTable::find
+
+Returns the Contact with the specified key (null if there is none),
+and marks it live in this frame.
+================================
+*/
+Contact* ContactTable::find( const ContactKey& key )
+{
+	int i = probe( key );
+	Entry& e = entries[i];
+	if ( !e.ct ) return 0;
+
+	e.frame = frame;
+	return e.ct;
+}
+
+/*
+================================
+ContactTable::insert
+
+The key must not be in the table already.
+================================
+*/
+void ContactTable::insert( const ContactKey& key, Contact* ct )
+{
+	// Keep the load factor at most one half
+	if ( 2 * ( n + 1 ) > (int) entries.size() ) grow();
+
+	Entry& e = entries[ probe( key ) ];
+	e.key = key;
+	e.ct = ct;
+	e.frame = frame;
+	++n;
+}
+
+/*
+================================
+ContactTable::erase
+================================
+*/
+void ContactTable::erase( const ContactKey& key )
+{
+	int i = probe( key );
+	if ( entries[i].ct ) erase_slot( i );
+}
+
+/*
+================================
+ContactTable::slot_of
+
+Returns the home slot of the specified key
+(an integer hash of its feature IDs).
+The slot count is always a power of two.
+================================
+*/
+int ContactTable::slot_of( const ContactKey& key ) const
+{
+	unsigned int h = 2166136261u;
+	const int fields[6] = {
+		key.a.pid, key.a.cid, key.a.fid,
+		key.b.pid, key.b.cid, key.b.fid };
+	for ( int f : fields ) {
+		h = ( h ^ (unsigned int) f ) * 16777619u;
+	}
+	h ^= h >> 15;
+	return h & ( entries.size() - 1 );
+}
+
+/*
+================================
+ContactTable::probe
+
+Returns the slot holding the specified key,
+or the empty slot where it would go.
+================================
+*/
+int ContactTable::probe( const ContactKey& key ) const
+{
+	int mask = entries.size() - 1;
+	int i = slot_of( key );
+	while ( entries[i].ct && !( entries[i].key == key ) ) {
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+/*
+================================
+ContactTable::erase_slot
+
+Empties the specified slot, then shifts back later entries
+of the same probe run that would no longer be found.
+================================
+*/
+void ContactTable::erase_slot( int i )
+{
+	int mask = entries.size() - 1;
+	int hole = i;
+	for ( int j = ( i + 1 ) & mask; entries[j].ct; j = ( j + 1 ) & mask ) {
+		// Entries whose home is cyclically in ( hole, j ] stay
+		int home = slot_of( entries[j].key );
+		if ( ( ( j - home ) & mask ) < ( ( j - hole ) & mask ) ) continue;
+
+		entries[ hole ] = entries[j];
+		hole = j;
+	}
+
+	entries[ hole ].ct = 0;
+	--n;
+}
+
+/*
+================================
+ContactTable::grow
+
+Doubles the slot count and re-inserts all entries.
+================================
+*/
+void ContactTable::grow()
+{
+	std::vector < Entry > old;
+	old.swap( entries );
+
+	Entry empty;
+	empty.ct = 0;
+	empty.frame = 0;
+	entries.assign( old.size() * 2, empty );
+
+	for ( const Entry& e : old ) {
+		if ( !e.ct ) continue;
+		entries[ probe( e.key ) ] = e;
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef PHYSICS_CONTACT_TABLE_H
+#define PHYSICS_CONTACT_TABLE_H
+
+#include <vector>
+#include "ContactKey.h"
+
+class Contact;
+
+/*
+================================
+ContactTable
+
+Maps ContactKeys to Contacts, for matching new contacts to old ones.
+
+Open addressing with linear probing: entries live inline
+in one power-of-two array, and erasing shifts the rest of
+the probe run back (no tombstones).
+
+Expiry is by frame stamp: every find or insert marks its entry
+as live in the current frame, and expire removes the entries
+that weren't, then starts a new frame.
+================================
+*/
+class ContactTable
+{
+public:
+	ContactTable();
+	~ContactTable() {}
+
+	Contact* find( const ContactKey& key );
+	void insert( const ContactKey& key, Contact* ct );
+	void erase( const ContactKey& key );
+
+	template < typename F >
+	void expire( F&& visit );
+
+	int size() const { return n; }
+	bool empty() const { return n == 0; }
+
+private: // Functions
+	int slot_of( const ContactKey& key ) const;
+	int probe( const ContactKey& key ) const;
+	void erase_slot( int i );
+	void grow();
+
+private: // Members
+	struct Entry
+	{
+		ContactKey key;
+		Contact* ct; // null for empty slots
+		unsigned int frame; // last frame this entry was live
+	};
+
+	std::vector < Entry > entries;
+	int n;
+	unsigned int frame;
+};
+
+/*
+================================
+ContactTable::expire
+
+Removes every entry that wasn't found or inserted
+since the last call, calling visit( ct ) for each
+(after it's out of the table), then starts a new frame.
+================================
+*/
+template < typename F >
+void ContactTable::expire( F&& visit )
+{
+	int size = entries.size();
+	for ( int i = 0; i < size; ) {
+		Entry& e = entries[i];
+		if ( e.ct && e.frame != frame ) {
+			Contact* ct = e.ct;
+			// Shifts a later entry into slot i, so look at it again
+			erase_slot( i );
+			visit( ct );
+		}
+		else {
+			++i;
+		}
+	}
+
+	++frame;
+}
+
+#endif
@@ -24,9 +24,12 @@ Distance::apply
 
 See "Advanced Character Physics" (2003) by Thomas Jakobsen:
 http://www.gamasutra.com/resource_guide/20030121/jacobson_01.shtml
+
+Returns the stretch ratio that was corrected
+(0 if this Distance was already satisfied).
 ================================
 */
-void Distance::apply()
+Scalar Distance::apply()
 {
 	Vec2 delta = b->position - a->position;
 
@@ -38,8 +41,8 @@ void Distance::apply()
 	delta_length = ( delta_length + mag2/delta_length ) * 0.5;
 
 	// Type check
-	if ( type == DC_PULL ) if ( delta_length < rest_length ) return;
-	if ( type == DC_PUSH ) if ( delta_length > rest_length ) return;
+	if ( type == DC_PULL ) if ( delta_length < rest_length ) return 0;
+	if ( type == DC_PUSH ) if ( delta_length > rest_length ) return 0;
 
 	// NOTE: At this point, we have the "stretch ratio".
 	// This isn't an appropriate place to break the constraint, though:
@@ -50,11 +53,14 @@ void Distance::apply()
 
 	// Correction
 	Scalar diff = ( delta_length - rest_length ) / ( delta_length );
+	Scalar stretch = std::fabs( diff );
 	diff *= power;
 	// Apply correction weighted by inverse mass.
 	diff /= a->mass + b->mass;
 	a->addPosition( delta * (  diff * b->mass ) );
 	b->addPosition( delta * ( -diff * a->mass ) );
+
+	return stretch;
 }
 
 /*
@@ -50,7 +50,7 @@ public: // "Entity" functions
 	AABB getAABB() const;
 
 public: // Distance functions
-	void apply();
+	Scalar apply();
 
 public: // Members
 	// Constraint properties
@@ -48,6 +48,7 @@ void PhysicsState::cleanup()
 	assert( cts.empty() );
 
 	assert( contact_cache.empty() );
+	manifolds.clear();
 
 	auto eus_copy = eus;
 	for ( Euler* eu : eus_copy ) destroyEuler( eu );
@@ -167,7 +168,8 @@ void PhysicsState::frame_printout( std::ostringstream& buffer )
 		<< "\n\t" << rigid_shapes.size() << " shapes"
 		<< "\n\t" << contact_cache.size() << " contacts cached"
 		<< "\n\t" << cts.size() << " contacts"
-		<< "\n\t" "across " << rigid_islands.size() << " islands";
+		<< "\n\t" "across " << rigid_islands.size() << " islands"
+		<< "\n\t" << rigid_iterations << " solver iterations";
 
 	buffer << "\n" << "Euler:"
 		<< "\n\t" << eus.size() << " euler particles";
@@ -176,7 +178,8 @@ void PhysicsState::frame_printout( std::ostringstream& buffer )
 		<< "\n\t" << vls.size() << " verlet particles"
 		<< "\n\t" << dcs.size() << " distance constraints"
 		<< "\n\t" << acs.size() << " angular constraints"
-		<< "\n\t" << "across " << verlet_islands.size() << " islands";
+		<< "\n\t" << "across " << verlet_islands.size() << " islands"
+		<< "\n\t" << verlet_iterations << " solver iterations";
 
 	buffer << "\n" << "next_pid: " << next_pid;
 }
@@ -1,11 +1,11 @@
 #include "PhysicsState.h"
 #include <queue>
-#include <algorithm> // for std::remove_if
-#include "spatial/PD_BruteForce.h"
-#include "spatial/RD_BruteForce.h"
+#include <algorithm> // for std::remove_if, std::sort, std::set_difference, std::merge
+#include <iterator> // for std::back_inserter
 
 // TODO: cleanup sat-caltrops
 #include "spatial/Segment.h"
+#include "spatial/SIMD.h" // for rigid_sweep_wide
 #include "spatial/Ray.h"
 
 /*
@@ -34,6 +34,14 @@ Clears all collision data from the last frame.
 void PhysicsState::clear_collision_data()
 {
 	rigid_shapes.clear();
+	rigid_points.clear();
+	rigid_normals.clear();
+	rigid_xs.clear();
+	rigid_ys.clear();
+	rigid_boxes.clear();
+	rigid_pairs.clear();
+
+	euler_grid.clear();
 
 	rigid_islands.clear();
 	verlet_islands.clear();
@@ -50,6 +58,7 @@ void PhysicsState::rigid_step()
 {
 	rigid_transform_convex();
 	rigid_detect_rigid();
+	rigid_expire_manifolds();
 	rigid_expire_contacts();
 	rigid_find_islands();
 	rigid_integrate();
@@ -59,12 +68,14 @@ void PhysicsState::rigid_step()
 ================================
 PhysicsState::rigid_transform_convex
 
-Makes copies of all Rigid-owned Convex shapes,
-transformed into world space and tagged with their owners.
+Copies all Rigid-owned Convex shapes, transformed into world space,
+into the flat shape buffers (tagged with their owners).
 This happens every frame; there are no deletion problems.
 
-TODO: A more sophisticated on-demand transforming scheme?
-Is it possible to broad-phase before transforming?
+Each Rigid caches its world-space shapes,
+so only bodies that moved are transformed again.
+
+TODO: Is it possible to broad-phase before transforming?
 
 TODO: Masking. Skip zero masks (is the mask in the rigid body, or the shape?)
 ================================
@@ -72,16 +83,49 @@ TODO: Masking. Skip zero masks (is the mask in the rigid body, or the shape?)
 void PhysicsState::rigid_transform_convex()
 {
 	for ( Rigid* rg : rgs ) {
-		int n = rg->shapes.size();
+		rg->update_world_shapes();
+		int n = rg->world_shapes.size();
 		for ( int i = 0; i < n; ++i ) {
-			Convex xf( rg->shapes[i] );
-			xf.transform( rg->position, rg->angular_position );
-			rigid_shapes.push_back( std::pair < ConvexTag, Convex >(
-				ConvexTag( rg, i ), xf ) );
+			const Convex& c = rg->world_shapes[i];
+
+			RigidShape shape;
+			shape.tag = ConvexTag( rg, i );
+			shape.offset = rigid_points.size();
+			shape.count = c.points.size();
+			shape.padded = c.xs.size();
+			shape.box = rg->world_boxes[i];
+			shape.center = rg->world_centers[i];
+			shape.radius = rg->radii[i];
+			rigid_shapes.push_back( shape );
+
+			// Pad the points and normals too, so all buffers share offsets
+			for ( int k = 0; k < shape.padded; ++k ) {
+				int kp = k < shape.count ? k : 0;
+				rigid_points.push_back( c.points[ kp ] );
+				rigid_normals.push_back( c.normals[ kp ] );
+			}
+			rigid_xs.insert( rigid_xs.end(), c.xs.begin(), c.xs.end() );
+			rigid_ys.insert( rigid_ys.end(), c.ys.begin(), c.ys.end() );
 		}
 	}
 }
 
+/*
+================================
+PhysicsState::rigid_shape
+
+Returns a view of the specified shape in the flat shape buffers
+(valid until the buffers are cleared by the next step).
+================================
+*/
+ConvexView PhysicsState::rigid_shape( int i ) const
+{
+	const RigidShape& shape = rigid_shapes[i];
+	return ConvexView(
+		&rigid_points[ shape.offset ], &rigid_normals[ shape.offset ], shape.count,
+		&rigid_xs[ shape.offset ], &rigid_ys[ shape.offset ], shape.padded );
+}
+
 /*
 ================================
 PhysicsState::rigid_detect_rigid
@@ -91,40 +135,170 @@ Detects all collisions between Rigid bodies.
 */
 void PhysicsState::rigid_detect_rigid()
 {
-	// The integer indexes rigid_shapes
-	RD_BruteForce < int > rd;
-	for ( unsigned int i = 0; i < rigid_shapes.size(); ++i ) {
-		Rigid* rg = rigid_shapes[i].first.first;
-		// int cid = rigid_shapes[i].first.second;
-		Convex& pg = rigid_shapes[i].second;
+	rigid_broad_phase();
+
+	for ( auto& pair : rigid_pairs ) {
+		int i = pair.first;
+		int j = pair.second;
+
+		Rigid* rg = rigid_shapes[i].tag.first;
+		Rigid* rg2 = rigid_shapes[j].tag.first;
 
-		AABB box = pg.getAABB();
+		// Avoid self-collision
+		if ( rg == rg2 ) continue;
+
+		// Avoid sad matrices
+		if ( rg->frozen() && rg2->frozen() ) continue;
+
+		// Masking
+		if ( !(rg->mask & rg2->mask) ) continue;
+
+		// Bounding circles (most broad-phase pairs stop here)
+		const RigidShape& si = rigid_shapes[i];
+		const RigidShape& sj = rigid_shapes[j];
+		Scalar r = si.radius + sj.radius;
+		if ( ( si.center - sj.center ).length2() > r * r ) continue;
+
+		// Narrow-phase
+		rigid_caltrops(
+			rigid_shapes[i].tag, rigid_shape( i ),
+			rigid_shapes[j].tag, rigid_shape( j ) );
+	}
+}
+
+/*
+================================
+PhysicsState::rigid_broad_phase
+
+Finds all pairs of rigid_shapes with overlapping (fattened) boxes,
+using the selected broad-phase algorithm.
+
+Pairs are reported as ( i, j ) with j < i, sorted,
+so contacts are always created in the same order
+no matter which algorithm is used (the solver is order-dependent).
+================================
+*/
+void PhysicsState::rigid_broad_phase()
+{
+	int n = rigid_shapes.size();
+	for ( int i = 0; i < n; ++i ) {
+		AABB box = rigid_shapes[i].box;
 		box.fatten( 2.0 );
+		rigid_boxes.push_back( box );
+	}
 
-		// Broad-phase happens here
-		for ( int j : rd.query( box ) ) {
-			Rigid* rg2 = rigid_shapes[j].first.first;
-			// int cid2 = rigid_shapes[j].first.second;
-			// Convex& pg2 = rigid_shapes[j].second;
+	switch ( broad_phase )
+	{
+	case BP_BRUTE_FORCE: {
+		rigid_brute_force.clear();
+		for ( int i = 0; i < n; ++i ) {
+			rigid_brute_force.insert( rigid_boxes[i], i );
+		}
+		rigid_brute_force.find_all_pairs( [this]( int i, int j ) {
+			rigid_pairs.push_back( std::pair < int, int >( i, j ) );
+		} );
+	}
+	break;
 
-			// Avoid self-collision
-			if ( rg == rg2 ) continue;
+	case BP_DYNAMIC_TREE: {
+		rigid_update_proxies( rigid_tree );
+		for ( int i = 0; i < n; ++i ) {
+			std::vector < int >& js = rigid_candidates;
+			rigid_tree.query( rigid_boxes[i], js );
+			std::sort( js.begin(), js.end() );
+			for ( int j : js ) {
+				// Only report each pair once (and not ourselves)
+				if ( j >= i ) break;
+				rigid_pairs.push_back( std::pair < int, int >( i, j ) );
+			}
+		}
+	}
+	break;
 
-			// Avoid sad matrices
-			if ( rg->frozen() && rg2->frozen() ) continue;
+	case BP_SWEEP_AND_PRUNE: {
+		rigid_update_proxies( rigid_sap );
 
-			// Masking
-			if ( !(rg->mask & rg2->mask) ) continue;
+		// Apply this step's pair events to last step's pairs
+		// (as ( hi, lo ), so they come out sorted like rigid_pairs)
+		rigid_sap.events( rigid_sap_added, rigid_sap_removed );
+		for ( auto* events : { &rigid_sap_added, &rigid_sap_removed } ) {
+			for ( std::pair < int, int >& pq : *events ) std::swap( pq.first, pq.second );
+			std::sort( events->begin(), events->end() );
+		}
+		std::vector < std::pair < int, int > >& kept = rigid_sap_scratch;
+		kept.clear();
+		std::set_difference(
+			rigid_sap_pairs.begin(), rigid_sap_pairs.end(),
+			rigid_sap_removed.begin(), rigid_sap_removed.end(),
+			std::back_inserter( kept ) );
+		rigid_sap_pairs.clear();
+		std::merge(
+			kept.begin(), kept.end(),
+			rigid_sap_added.begin(), rigid_sap_added.end(),
+			std::back_inserter( rigid_sap_pairs ) );
+
+		for ( const std::pair < int, int >& pq : rigid_sap_pairs ) {
+			int i = rigid_sap[ pq.first ];
+			int j = rigid_sap[ pq.second ];
+			if ( i < j ) std::swap( i, j );
+			rigid_pairs.push_back( std::pair < int, int >( i, j ) );
+		}
+		// Proxies are made in shape order, so this is usually sorted already
+		if ( ! std::is_sorted( rigid_pairs.begin(), rigid_pairs.end() ) ) {
+			std::sort( rigid_pairs.begin(), rigid_pairs.end() );
+		}
+	}
+	break;
 
-			// Narrow-phase
-			rigid_caltrops(
-				rigid_shapes[i].first, rigid_shapes[i].second,
-				rigid_shapes[j].first, rigid_shapes[j].second );
+	case BP_QUADTREE: {
+		if ( n == 0 ) break;
+		AABB bounds = rigid_boxes[0];
+		for ( int i = 1; i < n; ++i ) {
+			bounds += rigid_boxes[i];
+		}
+		rigid_quadtree.clear( bounds );
+		for ( int i = 0; i < n; ++i ) {
+			rigid_quadtree.insert( rigid_boxes[i], i );
 		}
+		for ( int i = 0; i < n; ++i ) {
+			std::vector < int >& js = rigid_candidates;
+			rigid_quadtree.query( rigid_boxes[i], js );
+			std::sort( js.begin(), js.end() );
+			for ( int j : js ) {
+				if ( j >= i ) break;
+				rigid_pairs.push_back( std::pair < int, int >( i, j ) );
+			}
+		}
+	}
+	break;
+	}
+}
 
-		// Broad-phase happens here
-		// Insert after query, so we don't query ourselves.
-		rd.insert( box, i );
+/*
+================================
+PhysicsState::rigid_update_proxies
+
+Moves every shape in a persistent broad-phase structure
+(inserting new shapes), and points each proxy at
+the shape's index in rigid_shapes for this frame.
+================================
+*/
+template < typename RD >
+void PhysicsState::rigid_update_proxies( RD& rd )
+{
+	int n = rigid_shapes.size();
+	for ( int i = 0; i < n; ++i ) {
+		Rigid* rg = rigid_shapes[i].tag.first;
+		int cid = rigid_shapes[i].tag.second;
+
+		int& proxy = rg->proxies[ cid ];
+		if ( proxy < 0 ) {
+			proxy = rd.insert( rigid_boxes[i], i );
+		}
+		else {
+			rd.move( proxy, rigid_boxes[i] );
+			rd[ proxy ] = i;
+		}
 	}
 }
 
@@ -133,14 +307,65 @@ void PhysicsState::rigid_detect_rigid()
 PhysicsState::rigid_caltrops
 
 Narrow phase.
+
+If the shapes have barely moved relative to each other
+since their last full narrow phase, the contacts found then
+are refreshed (same features, current positions) instead.
 ================================
 */
 void PhysicsState::rigid_caltrops(
-	ConvexTag& ta, Convex& a, ConvexTag& tb, Convex& b )
+	const ConvexTag& ta, const ConvexView& a, const ConvexTag& tb, const ConvexView& b )
 {
+	ShapePairKey pair_key;
+		pair_key.pid_a = ta.first->pid;
+		pair_key.cid_a = ta.second;
+		pair_key.pid_b = tb.first->pid;
+		pair_key.cid_b = tb.second;
+	auto find = manifolds.find( pair_key );
+	if ( find == manifolds.end() ) {
+		find = manifolds.insert( std::make_pair( pair_key, Manifold() ) ).first;
+	}
+	Manifold& m = find->second;
+	m.expired = false;
+
+	// Relative transform of B in A's frame
+	// (the world transforms are current, see rigid_transform_convex)
+	const Rigid* ra = ta.first;
+	const Rigid* rb = tb.first;
+	Vec2 position = ( rb->world_position - ra->world_position )
+		.rotation( ra->world_cos, -ra->world_sin );
+	Scalar angle = rb->world_angle - ra->world_angle;
+
+	// Barely moved: refresh the old contacts
+	const Scalar tol = PHYSICS_MANIFOLD_LINEAR_TOLERANCE;
+	if ( m.points.size() > 0 &&
+		( position - m.position ).length2() < tol * tol &&
+		std::fabs( angle - m.angle ) < PHYSICS_MANIFOLD_ANGULAR_TOLERANCE ) {
+		for ( const ManifoldPoint& mp : m.points ) {
+			const ConvexView& r = mp.flip ? b : a;
+			const ConvexView& in = mp.flip ? a : b;
+
+			// Vertices that moved out of the edge are dropped
+			// (as a full narrow phase would)
+			Wall w( r.points[ mp.ir ], r.normals[ mp.ir ] );
+			if ( w.distance( in.points[ mp.ii ] ) > 0 ) continue;
+
+			if ( mp.flip ) rigid_contact( tb, b, mp.ir, ta, a, mp.ii );
+			else rigid_contact( ta, a, mp.ir, tb, b, mp.ii );
+		}
+		return;
+	}
+
+	m.position = position;
+	m.angle = angle;
+
 	// Make sure these shapes are overlapping
-	auto sat = Convex::sat( a, b );
-	if ( ! sat.first ) return;
+	// (starting from last frame's axis for this pair)
+	auto sat = Convex::sat( a, b, m.axis );
+	if ( ! sat.first ) {
+		m.points.clear();
+		return;
+	}
 
 	// Caltrop measurements
 	Vec2 caltrop_unit( sat.second * 2.0 );
@@ -154,200 +379,310 @@ void PhysicsState::rigid_caltrops(
 	Vec2 x = y.rperp();
 	Wall wx( Vec2(0), x.lperp() );
 
-	// Produce the AABBs for the basis ( n.rperp(), n )
-	int na = a.points.size();
-	auto sya = wy.shadow( a );
-	auto sxa = wx.shadow( a );
+	// Caltrops on B against A, then on A against B
+	rigid_hits.clear();
+	rigid_fire_caltrops( a, b, -caltrop_unit, caltrop_length, wy, wx, false );
+	rigid_fire_caltrops( b, a, caltrop_unit, caltrop_length, wy, wx, true );
 
-	int nb = b.points.size();
-	auto syb = wy.shadow( b );
-	auto sxb = wx.shadow( b );
+	// Only make Contacts for the hits worth keeping
+	rigid_reduce_manifold( m );
+	for ( const ManifoldPoint& mp : m.points ) {
+		if ( mp.flip ) rigid_contact( tb, b, mp.ir, ta, a, mp.ii );
+		else rigid_contact( ta, a, mp.ir, tb, b, mp.ii );
+	}
+}
 
-	// Caltrops on B against A
-	caltrop_unit = -caltrop_unit;
-	for ( int ib = 0; ib < nb; ++ib ) {
-		Vec2& pb = b.points[ ib ];
+/*
+================================
+PhysicsState::rigid_fire_caltrops
+
+Fires a caltrop (a short ray along u, ending at the vertex)
+from each vertex of the incident polygon at the reference polygon,
+and records each vertex (and the edge its caltrop hits) in rigid_hits.
+
+A caltrop hits the first edge (by index) that doesn't face away
+from it and that it intersects. Only edges facing the caltrops
+can be crossed, and they form a chain that is monotone across u,
+so each vertex binary-searches the chain for its edge, then walks
+to the neighbors that it also intersects (where the caltrop passes
+through a vertex, or along an edge parallel to u).
+
+Vertices are culled against the reference polygon's shadows
+on the specified Y-wall (the SAT axis) and X-wall.
+flip says whether the reference polygon is the pair's B.
+================================
+*/
+void PhysicsState::rigid_fire_caltrops(
+	const ConvexView& r, const ConvexView& in,
+	const Vec2& u, Scalar length,
+	const Wall& wy, const Wall& wx, bool flip )
+{
+	int nr = r.points.size();
+	int ni = in.points.size();
+
+	// Find the chain of reference edges facing the caltrops
+	// (first, first+1, ..., first+m-1, wrapping around)
+	int first = 0, m = 0;
+	for ( int k = 0; k < nr; ++k ) {
+		if ( !( u * r.normals[k] < 0 ) ) continue;
+		++m;
+		if ( !( u * r.normals[ (k+nr-1) % nr ] < 0 ) ) first = k;
+	}
+	if ( m == 0 ) return;
+
+	// Chain points are sorted across the caltrops
+	// (the sign makes them ascending)
+	Vec2 x = u.rperp();
+	Scalar sign = r.points[ first ] * x <= r.points[ (first+m) % nr ] * x ? 1 : -1;
+	auto across = [&]( int j ) {
+		return sign * ( r.points[ (first+j) % nr ] * x );
+	};
+
+	// Shadows of the reference polygon
+	auto sy = wy.shadow( r );
+	auto sx = wx.shadow( r );
+
+	for ( int ii = 0; ii < ni; ++ii ) {
+		const Vec2& pv = in.points[ ii ];
 
 		// Y-culling
-		Scalar sypb = wy.shadow( pb );
-		if ( sypb > sya.second ) continue;
+		Scalar sypv = wy.shadow( pv );
+		if ( flip ? sypv < sy.first : sypv > sy.second ) continue;
 
-		// X culling
-		Scalar sxpb = wx.shadow( pb );
-		if ( sxpb < sxa.first || sxa.second < sxpb ) continue;
+		// X-culling
+		Scalar sxpv = wx.shadow( pv );
+		if ( sxpv < sx.first || sx.second < sxpv ) continue;
 
 		// This is the caltrop
-		Ray r( pb - caltrop_unit * caltrop_length, caltrop_unit );
-
-		// Fire the caltrop at each segment
-		for ( int ia = 0; ia < na; ++ia ) {
-			Vec2& n = a.normals[ ia ];
-			if ( caltrop_unit * n > 0 ) continue;
-
-			Vec2& p = a.points[ ia ];
-			Vec2& q = a.points[ (ia+1) % na ];
-			Segment s( p, q );
-
-			auto rxs = r.intersects( s );
-			if ( ! rxs.first ) continue;
-			// We actually found a Ray-Convex intersection here,
-			// so from now on all filters use break instead of continue.
-
-			if ( rxs.second > caltrop_length ) break;
-
-			// Only admit caltrops whose endpoints project onto the segment
-			if ( Wall( p, n.lperp() ).contains( pb ) ) break;
-			if ( Wall( q, n.rperp() ).contains( pb ) ) break;
-
-			// Generate unique key for this Contact
-			ContactKey key;
-				key.a.pid = ta.first->pid;
-				key.a.cid = ta.second;
-				key.a.fid = ia;
-				key.b.pid = tb.first->pid;
-				key.b.cid = tb.second;
-				key.b.fid = ib;
-
-			// Hit the Contact cache or make a new Contact
-			auto cc = createContact( ta.first, tb.first, key );
-			Contact* ct = cc.second;
-
-			Wall w( p, n );
-			ct->overlap = - w.distance( pb );
-			ct->normal = w.normal;
-			ct->a_p = w.nearest( pb );
-			ct->b_p = pb;
-
-			// Compute "local lambda" for new contacts
-			// (after writing to ct)
-			if ( ! cc.first ) {
-				ct->lambda = ct->local_lambda();
-
-				// Friction optimization
-				// TODO: Floating point == seems like a bad idea
-				if ( Friction::mix_friction( ta.first->friction, tb.first->friction ) == 0.0 ) {
-					ct->ft = 0;
-				}
-				else {
-					// TODO: This logic is kind of bad?
-					// 1. createFriction is far from createContact
-					// 2. Every narrow-phase will have to create Friction
-					ct->ft = createFriction( ta.first, tb.first );
-				}
-			}
+		Ray caltrop( pv - u * length, u );
+
+		// The chain edge whose ends straddle the caltrop
+		Scalar xv = sign * ( pv * x );
+		int lo = 0, hi = m - 1;
+		while ( lo < hi ) {
+			int mid = ( lo + hi + 1 ) / 2;
+			if ( across( mid ) <= xv ) lo = mid;
+			else hi = mid - 1;
+		}
 
-			// Apply friction at the same point on both bodies
-			if ( ct->ft ) {
-				ct->ft->normal_lambda = ct->lambda;
-				ct->ft->tangent = w.normal.lperp();
-				ct->ft->p = (ct->a_p + ct->b_p) * 0.5;
+		// The first edge hit: that one, or one of
+		// the neighbors the caltrop also intersects
+		int ir = -1;
+		Scalar t = 0;
+		auto crosses = [&]( int k ) {
+			if ( u * r.normals[k] > 0 ) return false;
+			auto rxs = caltrop.intersects( Segment( r.points[k], r.points[ (k+1) % nr ] ) );
+			if ( ! rxs.first ) return false;
+			if ( ir < 0 || k < ir ) {
+				ir = k;
+				t = rxs.second;
 			}
-
-			break; // Only one intersection per caltrop
-		}
+			return true;
+		};
+		int c = ( first + lo ) % nr;
+		crosses( c );
+		for ( int k = c, j = 1; j < nr && crosses( k = (k+nr-1) % nr ); ++j ) {}
+		for ( int k = c, j = 1; j < nr && crosses( k = (k+1) % nr ); ++j ) {}
+		if ( ir < 0 ) continue;
+
+		const Vec2& n = r.normals[ ir ];
+		const Vec2& p = r.points[ ir ];
+		const Vec2& q = r.points[ (ir+1) % nr ];
+
+		// The caltrop must reach the edge
+		if ( t > length ) continue;
+
+		// Only admit caltrops whose endpoints project onto the segment
+		if ( Wall( p, n.lperp() ).contains( pv ) ) continue;
+		if ( Wall( q, n.rperp() ).contains( pv ) ) continue;
+
+		CaltropHit hit;
+			hit.mp.flip = flip;
+			hit.mp.ir = ir;
+			hit.mp.ii = ii;
+			hit.depth = - Wall( p, n ).distance( pv );
+			hit.p = pv;
+			hit.kept = false;
+			hit.chosen = false;
+		rigid_hits.push_back( hit );
 	}
+}
 
-	// Caltrops on A against B
-	caltrop_unit = -caltrop_unit;
-	for ( int ia = 0; ia < na; ++ia ) {
-		Vec2& pa = a.points[ ia ];
-
-		Scalar sypa = wy.shadow( pa );
-		if ( sypa < syb.first ) continue;
-
-		Scalar sxpa = wx.shadow( pa );
-		if ( sxpa < sxb.first || sxb.second < sxpa ) continue;
-
-		Ray r( pa - caltrop_unit * caltrop_length, caltrop_unit );
-
-		for ( int ib = 0; ib < nb; ++ib ) {
-			Vec2& n = b.normals[ ib ];
-			if ( caltrop_unit * n > 0 ) continue;
-
-			Vec2& p = b.points[ ib ];
-			Vec2& q = b.points[ (ib+1) % nb ];
-			Segment s( p, q );
+/*
+================================
+PhysicsState::rigid_reduce_manifold
 
-			auto rxs = r.intersects( s );
-			if ( ! rxs.first ) continue;
+Replaces the points of the specified manifold with
+at most PHYSICS_MANIFOLD_POINTS of this pair's caltrop hits:
+the deepest hit, then whichever hit is farthest from
+those already chosen, so the chosen ones span the contact.
 
-			if ( rxs.second > caltrop_length ) break;
+Ties (see PHYSICS_MANIFOLD_REDUCTION_TOLERANCE) go to hits
+the manifold already had, so a resting pair keeps its
+Contact keys (and their lambdas) from frame to frame.
+================================
+*/
+void PhysicsState::rigid_reduce_manifold( Manifold& m )
+{
+	int n = rigid_hits.size();
+	if ( n <= PHYSICS_MANIFOLD_POINTS ) {
+		m.points.clear();
+		for ( const CaltropHit& hit : rigid_hits ) m.points.push_back( hit.mp );
+		return;
+	}
 
-			if ( Wall( p, n.lperp() ).contains( pa ) ) break;
-			if ( Wall( q, n.rperp() ).contains( pa ) ) break;
+	for ( CaltropHit& hit : rigid_hits ) {
+		for ( const ManifoldPoint& mp : m.points ) {
+			if ( mp.flip == hit.mp.flip && mp.ir == hit.mp.ir && mp.ii == hit.mp.ii ) {
+				hit.kept = true;
+			}
+		}
+	}
 
-			ContactKey key;
-				key.a.pid = tb.first->pid;
-				key.a.cid = tb.second;
-				key.a.fid = ib;
-				key.b.pid = ta.first->pid;
-				key.b.cid = ta.second;
-				key.b.fid = ia;
+	// Is hit i (scoring si) better than hit j (scoring sj)?
+	auto better = [&]( int i, Scalar si, int j, Scalar sj ) {
+		if ( std::fabs( si - sj ) > PHYSICS_MANIFOLD_REDUCTION_TOLERANCE ) return si > sj;
+		return rigid_hits[i].kept && ! rigid_hits[j].kept;
+	};
+
+	// The deepest hit
+	int deepest = 0;
+	for ( int i = 1; i < n; ++i ) {
+		if ( better( i, rigid_hits[i].depth, deepest, rigid_hits[deepest].depth ) ) {
+			deepest = i;
+		}
+	}
 
-			auto cc = createContact( tb.first, ta.first, key );
-			Contact* ct = cc.second;
+	m.points.clear();
+	m.points.push_back( rigid_hits[ deepest ].mp );
+	rigid_hits[ deepest ].chosen = true;
 
-			Wall w( p, n );
-			ct->overlap = - w.distance( pa );
-			ct->normal = w.normal;
-			ct->a_p = w.nearest( pa );
-			ct->b_p = pa;
+	// Then the farthest hits
+	while ( m.points.size() < PHYSICS_MANIFOLD_POINTS ) {
+		int farthest = -1;
+		Scalar farthest_spread = 0;
+		for ( int i = 0; i < n; ++i ) {
+			if ( rigid_hits[i].chosen ) continue;
 
-			if ( ! cc.first ) {
-				ct->lambda = ct->local_lambda();
-				if ( Friction::mix_friction( tb.first->friction, ta.first->friction ) == 0.0 ) {
-					ct->ft = 0;
-				}
-				else {
-					ct->ft = createFriction( tb.first, ta.first );
-				}
+			Scalar spread = -1;
+			for ( int j = 0; j < n; ++j ) {
+				if ( ! rigid_hits[j].chosen ) continue;
+				Scalar d = ( rigid_hits[i].p - rigid_hits[j].p ).length();
+				if ( spread < 0 || d < spread ) spread = d;
 			}
 
-			if ( ct->ft ) {
-				ct->ft->normal_lambda = ct->lambda;
-				ct->ft->tangent = w.normal.lperp();
-				ct->ft->p = (ct->b_p + ct->a_p) * 0.5;
+			if ( farthest < 0 || better( i, spread, farthest, farthest_spread ) ) {
+				farthest = i;
+				farthest_spread = spread;
 			}
-
-			break; // Only one intersection per caltrop
 		}
+		if ( farthest < 0 ) break;
+
+		m.points.push_back( rigid_hits[ farthest ].mp );
+		rigid_hits[ farthest ].chosen = true;
 	}
 }
 
-// Returns a list of all Contacts (from the contact_cache).
-std::list < Contact* > PhysicsState::contacts()
-{
-	std::list < Contact* > ret;
+/*
+================================
+PhysicsState::rigid_contact
+
+Makes (or refreshes) the Contact between the specified
+reference edge and incident vertex.
 
-	for ( auto& pair : contact_cache ) {
-		ret.push_back( pair.second );
+Contacts are keyed by ( reference edge, incident vertex ).
+================================
+*/
+void PhysicsState::rigid_contact(
+	const ConvexTag& tr, const ConvexView& r, int ir,
+	const ConvexTag& ti, const ConvexView& in, int ii )
+{
+	Wall w( r.points[ ir ], r.normals[ ir ] );
+	const Vec2& pv = in.points[ ii ];
+
+	// Generate unique key for this Contact
+	ContactKey key;
+		key.a.pid = tr.first->pid;
+		key.a.cid = tr.second;
+		key.a.fid = ir;
+		key.b.pid = ti.first->pid;
+		key.b.cid = ti.second;
+		key.b.fid = ii;
+
+	// Hit the Contact cache or make a new Contact
+	auto cc = createContact( tr.first, ti.first, key );
+	Contact* ct = cc.second;
+
+	ct->overlap = - w.distance( pv );
+	ct->normal = w.normal;
+	ct->a_p = w.nearest( pv );
+	ct->b_p = pv;
+
+	// Compute "local lambda" for new contacts
+	// (after writing to ct)
+	if ( ! cc.first ) {
+		ct->lambda = ct->local_lambda();
+
+		// Friction optimization
+		// TODO: Floating point == seems like a bad idea
+		if ( Friction::mix_friction( tr.first->friction, ti.first->friction ) == 0.0 ) {
+			ct->ft = 0;
+		}
+		else {
+			// TODO: This logic is kind of bad?
+			// 1. createFriction is far from createContact
+			// 2. Every narrow-phase will have to create Friction
+			ct->ft = createFriction( tr.first, ti.first );
+		}
 	}
 
-	return ret;
+	// Apply friction at the same point on both bodies
+	if ( ct->ft ) {
+		ct->ft->normal_lambda = ct->lambda;
+		ct->ft->tangent = w.normal.lperp();
+		ct->ft->p = (ct->a_p + ct->b_p) * 0.5;
+	}
 }
 
 /*
 ================================
-PhysicsState::rigid_expire_contacts
+PhysicsState::rigid_expire_manifolds
 
-TODO: ???
+Forgets the manifolds of shape pairs that
+didn't reach the narrow phase this frame.
 ================================
 */
-void PhysicsState::rigid_expire_contacts()
+void PhysicsState::rigid_expire_manifolds()
 {
-	for ( Contact* ct : contacts() ) {
-		if ( ct->expired ) {
-			if ( ct->ft ) {
-				destroyFriction( ct->ft );
-			}
-			destroyContact( ct );
+	for ( auto it = manifolds.begin(); it != manifolds.end(); ) {
+		if ( it->second.expired ) {
+			it = manifolds.erase( it );
 		}
 		else {
-			ct->expired = true;
+			it->second.expired = true;
+			++it;
 		}
 	}
 }
 
+/*
+================================
+PhysicsState::rigid_expire_contacts
+
+Destroys the Contacts that weren't made again this frame.
+================================
+*/
+void PhysicsState::rigid_expire_contacts()
+{
+	contact_cache.expire( [this]( Contact* ct ) {
+		if ( ct->ft ) {
+			destroyFriction( ct->ft );
+		}
+		cts.erase( ct->it );
+		delete ct;
+	} );
+}
+
 /*
 ================================
 PhysicsState::rigid_find_islands
@@ -428,24 +763,63 @@ void PhysicsState::rigid_apply_wind_forces()
 PhysicsState::rigid_solve_islands
 
 Computes and applies constraint forces for each Rigid island.
+
+Islands only share frozen bodies (which the solver never writes),
+so they are solved in parallel (see setSolverThreads),
+most expensive first, so a big island starts early instead of
+being left for last. Each island is solved exactly as it would be
+alone, so the results don't depend on the number of threads.
+
+Islands with at least PHYSICS_COLORED_ISLAND_ROWS constraints
+are solved first, one at a time, each using every thread.
 ================================
 */
 void PhysicsState::rigid_solve_islands()
 {
-	for ( RigidIsland& rgi : rigid_islands ) {
-		rigid_solve_island( rgi );
+	rigid_iterations = 0;
+
+	int k = rigid_islands.size();
+	island_order.clear();
+	for ( int i = 0; i < k; ++i ) {
+		int n = rigid_islands[i].first.size();
+		int s = rigid_islands[i].second.size();
+		if ( s >= PHYSICS_COLORED_ISLAND_ROWS ) {
+			rigid_iterations += rigid_solve_island( rigid_islands[i], rigid_workspaces[0], true );
+			continue;
+		}
+		int cost = s * (int) std::ceil( std::sqrt( s + n ) );
+		island_order.push_back( std::make_pair( -cost, i ) );
 	}
+	std::sort( island_order.begin(), island_order.end() );
+
+	solver_pool.run( island_order.size(), [this]( int i, int worker ) {
+		RigidIsland& rgi = rigid_islands[ island_order[i].second ];
+		rigid_iterations += rigid_solve_island( rgi, rigid_workspaces[ worker ], false );
+	} );
 }
 
 /*
 ================================
 PhysicsState::rigid_solve_island
 
-Computes and applies constraint forces for the specified Rigid island.
+Computes and applies constraint forces for the specified Rigid island,
+using (and overwriting) the specified workspace.
 PDF: Interactive Dynamics (Catto 2005)
+
+Islands with at least PHYSICS_COLORED_ISLAND_ROWS constraints
+have their constraints colored, so that no two constraints of
+a color share a (non-frozen) body, and sorted by color.
+Constraints of one color don't affect each other, so if parallel
+is set, each color is split across the solver threads.
+The sweep order doesn't depend on the number of threads.
+
+Stops early once an iteration changes no lambda by more than
+PHYSICS_RIGID_SOLVER_TOLERANCE (so well warm-started islands
+take PHYSICS_RIGID_SOLVER_MIN_ITERATIONS).
+Returns the number of iterations used.
 ================================
 */
-void PhysicsState::rigid_solve_island( RigidIsland& rgi )
+int PhysicsState::rigid_solve_island( RigidIsland& rgi, IslandWorkspace& ws, bool parallel )
 {
 	// NOTE: This shadows this->rgs and this->cts
 	std::vector < Rigid* >& rgs = rgi.first;
@@ -475,102 +849,223 @@ void PhysicsState::rigid_solve_island( RigidIsland& rgi )
 	// TODO: Okay, so minor_id out of PhysicsGraph isn't really useful,
 	// because frozen objects belong to multiple islands. Without this,
 	// forces mess up, and then the -1 index causes weird segfaults.
+	// Frozen objects may be in islands being solved on other threads,
+	// so they are never tagged: their local ID is found by PID instead.
 	for ( int i = 0; i < n; ++i ) {
+		if ( rgs[i]->frozen() ) continue;
 		rgs[i]->minor_id = i;
 	}
-
-	// Velocity vector, V
-	auto V = std::vector < Vec3 >( n );
-	for ( int i = 0; i < n; ++i ) {
-		Rigid* rg = rgs[i];
-		V[i] = rg->getVelocityState();
+	auto local_id = [&rgs]( Rigid* rg ) -> int {
+		if ( ! rg->frozen() ) return rg->minor_id;
+		return std::lower_bound( rgs.begin(), rgs.end(), rg, PhysicsTags::pid_lt ) - rgs.begin();
+	};
+
+	// Color big islands
+	// (greedily, in PID order; constraints that don't
+	// fit in the 64 colors go in a last, serial, batch)
+	ws.colors.clear();
+	if ( s >= PHYSICS_COLORED_ISLAND_ROWS ) {
+		ws.body_colors.assign( n, 0 );
+		ws.row_colors.resize( s );
+		std::vector < int >& counts = ws.colors;
+		counts.assign( 66, 0 );
+		for ( int i = 0; i < s; ++i ) {
+			Rigid* ra = cts[i]->a;
+			Rigid* rb = cts[i]->b;
+			uint64_t used = 0;
+			if ( ! ra->frozen() ) used |= ws.body_colors[ local_id( ra ) ];
+			if ( ! rb->frozen() ) used |= ws.body_colors[ local_id( rb ) ];
+			int c = 0;
+			while ( c < 64 && ( used >> c & 1 ) ) ++c;
+			if ( c < 64 ) {
+				if ( ! ra->frozen() ) ws.body_colors[ local_id( ra ) ] |= uint64_t( 1 ) << c;
+				if ( ! rb->frozen() ) ws.body_colors[ local_id( rb ) ] |= uint64_t( 1 ) << c;
+			}
+			ws.row_colors[i] = c;
+			++counts[ c + 1 ];
+		}
+		// Counting sort (stable, so PID order within colors)
+		for ( int c = 0; c < 65; ++c ) counts[ c + 1 ] += counts[c];
+		ws.rows.resize( s );
+		for ( int i = 0; i < s; ++i ) {
+			ws.rows[ counts[ ws.row_colors[i] ]++ ] = cts[i];
+		}
+		std::copy( ws.rows.begin(), ws.rows.end(), cts.begin() );
+		// (counts[c] is now where color c ends)
+		counts.insert( counts.begin(), 0 );
+		counts.pop_back();
 	}
 
+	// (resize keeps capacity, so this only allocates
+	// for the biggest island seen so far)
+	ws.V.resize( n );
+	ws.M.resize( n );
+	ws.a.assign( n, Vec3() );
+	ws.F.assign( n, Vec3() );
+	ws.J_a.resize( s );
+	ws.J_b.resize( s );
+	ws.B_a.resize( s );
+	ws.B_b.resize( s );
+	ws.map_a.resize( s );
+	ws.map_b.resize( s );
+	ws.H.resize( s );
+	ws.d.resize( s );
+	ws.L.resize( s );
+	ws.lo.resize( s );
+	ws.hi.resize( s );
+	ws.fixed.resize( n );
+
+	Vec3* V = ws.V.data();
+	Vec3* M = ws.M.data();
+	Vec3* a = ws.a.data();
+	Vec3* F = ws.F.data();
+	Vec3* J_a = ws.J_a.data();
+	Vec3* J_b = ws.J_b.data();
+	Vec3* B_a = ws.B_a.data();
+	Vec3* B_b = ws.B_b.data();
+	int* map_a = ws.map_a.data();
+	int* map_b = ws.map_b.data();
+	Scalar* H = ws.H.data();
+	Scalar* d = ws.d.data();
+	Scalar* L = ws.L.data();
+	Scalar* lo = ws.lo.data();
+	Scalar* hi = ws.hi.data();
+	char* fixed = ws.fixed.data();
+
+	// Velocity vector, V
 	// Inverse mass matrix, M
-	auto M = std::vector < Vec3 >( n );
 	for ( int i = 0; i < n; ++i ) {
 		Rigid* rg = rgs[i];
+		V[i] = rg->getVelocityState();
 		M[i] = rg->getInverseMass();
+		fixed[i] = rg->frozen();
 	}
 
 	// Jacobian matrix, J
-	auto J_sp = std::vector < std::pair < Vec3, Vec3 > >( s );
-	auto J_map = std::vector < std::pair < int, int > >( s );
+	// Constraint bounds (constant while solving)
+	// Warm starting, L
 	for ( int i = 0; i < s; ++i ) {
 		Constraint* ct = cts[i];
-		J_sp[i] = ct->jacobian();
-		J_map[i] = std::pair < int, int >(
-			ct->a->minor_id,
-			ct->b->minor_id );
+		auto J = ct->jacobian();
+		J_a[i] = J.first;
+		J_b[i] = J.second;
+		map_a[i] = local_id( ct->a );
+		map_b[i] = local_id( ct->b );
+		auto bounds = ct->bounds();
+		lo[i] = bounds.first;
+		hi[i] = bounds.second;
+		L[i] = ct->lambda;
 	}
 
 	// Constraint velocity vector, H (eta)
-	auto H = std::vector < Scalar >( s );
 	for ( int i = 0; i < s; ++i ) {
 		Scalar jv =
-			J_sp[i].first.dot( V[ J_map[i].first ] ) +
-			J_sp[i].second.dot( V[ J_map[i].second ] );
+			J_a[i].dot( V[ map_a[i] ] ) +
+			J_b[i].dot( V[ map_b[i] ] );
 		H[i] = cts[i]->bias( jv ) - jv;
 	}
 
 	// B = M J
-	auto B_sp = std::vector < std::pair < Vec3, Vec3 > >( s );
 	for ( int i = 0; i < s; ++i ) {
-		B_sp[i].first = J_sp[i].first.prod( M[ J_map[i].first ] );
-		B_sp[i].second = J_sp[i].second.prod( M[ J_map[i].second ] );
+		B_a[i] = J_a[i].prod( M[ map_a[i] ] );
+		B_b[i] = J_b[i].prod( M[ map_b[i] ] );
 	}
 
 	// Constraint force vector, L
-	auto a = std::vector < Vec3 >( n );
-	auto d = std::vector < Scalar >( s );
-	auto L = std::vector < Scalar >( s );
-	auto L_0 = std::vector < Scalar >( s );
-	// Warm starting
-	for ( int i = 0; i < s; ++i ) {
-		L_0[i] = cts[i]->lambda;
-	}
-	L = L_0;
 	// Initialize a = B L
 	for ( int i = 0; i < s; ++i ) {
-		a[ J_map[i].first ] += B_sp[i].first * L[i]; // scale
-		a[ J_map[i].second ] += B_sp[i].second * L[i]; // scale
+		a[ map_a[i] ] += B_a[i] * L[i]; // scale
+		a[ map_b[i] ] += B_b[i] * L[i]; // scale
 	}
 	// Initialize diagonal
 	for ( int i = 0; i < s; ++i ) {
 		d[i] =
-			B_sp[i].first.dot( J_sp[i].first ) +
-			B_sp[i].second.dot( J_sp[i].second );
+			B_a[i].dot( J_a[i] ) +
+			B_b[i].dot( J_b[i] );
 	}
-	// Estimate the number of iterations needed
-	int m = (int) std::ceil( std::sqrt( s + n ) ) * 4;
-	// Solve for L with Projected Gauss-Seidel
-	for ( int j = 0; j < m; ++j ) {
+	// Wide rows: J and B by component
+	bool wide = wide_rows && ! ws.colors.empty();
+	if ( wide ) {
+		for ( int k = 0; k < 12; ++k ) ws.JB[k].resize( s );
 		for ( int i = 0; i < s; ++i ) {
-			int b1 = J_map[i].first;
-			int b2 = J_map[i].second;
-			Scalar delta = ( H[i] - (
-				J_sp[i].first.dot( a[b1] ) +
-				J_sp[i].second.dot( a[b2] ) ) ) / d[i];
-			L_0[i] = L[i];
-			Scalar tmp =  L_0[i] + delta;
-			auto bounds = cts[i]->bounds();
-			clamp( tmp, bounds.first, bounds.second );
-			L[i] = tmp;
-			delta = L[i] - L_0[i];
-			a[b1] += B_sp[i].first * delta; // scale
-			a[b2] += B_sp[i].second * delta; // scale
+			const Vec3* rows[4] = { &J_a[i], &J_b[i], &B_a[i], &B_b[i] };
+			for ( int k = 0; k < 12; ++k ) ws.JB[k][i] = (*rows[ k / 3 ])[ k % 3 ];
 		}
 	}
+	// Estimate the number of iterations needed (at most)
+	int m = (int) std::ceil( std::sqrt( s + n ) ) * 4;
+	m = std::max( m, PHYSICS_RIGID_SOLVER_MIN_ITERATIONS );
+	auto finished = [m]( int used, Scalar change ) {
+		return used >= m || ( used >= PHYSICS_RIGID_SOLVER_MIN_ITERATIONS &&
+			change < PHYSICS_RIGID_SOLVER_TOLERANCE );
+	};
+	// Solve for L with Projected Gauss-Seidel
+	// (rows of one color can be swept wide, see rigid_sweep_wide)
+	auto sweep = [&]( int first, int last ) -> Scalar {
+		if ( wide ) return rigid_sweep_wide( ws, first, last );
+		else return rigid_sweep_rows( ws, first, last );
+	};
+	const std::vector < int >& colors = ws.colors;
+	int threads = solver_pool.size();
+	int used = 0;
+	if ( colors.empty() ) {
+		Scalar change;
+		do {
+			change = rigid_sweep_rows( ws, 0, s );
+		} while ( ! finished( ++used, change ) );
+	}
+	else if ( ! parallel || threads == 1 ) {
+		Scalar change;
+		do {
+			change = 0;
+			for ( int c = 0; c < 64; ++c ) {
+				change = std::max( change, sweep( colors[c], colors[ c + 1 ] ) );
+			}
+			change = std::max( change, rigid_sweep_rows( ws, colors[64], colors[65] ) );
+		} while ( ! finished( ++used, change ) );
+	}
+	else {
+		// Every thread sees the same changes, so they all stop together
+		// (there are two sets, so the next iteration's doesn't
+		// overwrite one that another thread is still reading)
+		ws.changes.assign( 2 * threads, 0 );
+		SpinBarrier barrier( threads );
+		solver_pool.run( threads, [&]( int t, int worker ) {
+			for ( int j = 0; ; ++j ) {
+				Scalar change = 0;
+				for ( int c = 0; c < 64; ++c ) {
+					int first = colors[c];
+					int count = colors[ c + 1 ] - first;
+					if ( count == 0 ) continue;
+					change = std::max( change, sweep(
+						first + count * t / threads, first + count * ( t + 1 ) / threads ) );
+					barrier.wait();
+				}
+				// Leftovers
+				if ( t == 0 ) {
+					change = std::max( change, rigid_sweep_rows( ws, colors[64], colors[65] ) );
+				}
+				Scalar* changes = &ws.changes[ ( j % 2 ) * threads ];
+				changes[t] = change;
+				barrier.wait();
+
+				for ( int k = 0; k < threads; ++k ) change = std::max( change, changes[k] );
+				if ( finished( j + 1, change ) ) {
+					if ( t == 0 ) used = j + 1;
+					return;
+				}
+			}
+		} );
+	}
 	// Store new lambdas
 	for ( int i = 0; i < s; ++i ) {
 		cts[i]->lambda = L[i];
 	}
 
 	// Compute F_c = Jt L
-	auto F = std::vector < Vec3 >( n );
 	for ( int i = 0; i < s; ++i ) {
-		F[ J_map[i].first ] += J_sp[i].first * L[i]; // scale
-		F[ J_map[i].second ] += J_sp[i].second * L[i]; // scale
+		F[ map_a[i] ] += J_a[i] * L[i]; // scale
+		F[ map_b[i] ] += J_b[i] * L[i]; // scale
 	}
 
 	// Integrate velocity
@@ -581,15 +1076,191 @@ void PhysicsState::rigid_solve_island( RigidIsland& rgi )
 	}
 
 	// Set new velocity
+	// (frozen objects can't be changed, and may be shared)
 	for ( int i = 0; i < n; ++i ) {
 		Rigid* rg = rgs[i];
+		if ( rg->frozen() ) continue;
 		rg->setVelocityState( V[i] );
 	}
 
 	// Clear local ID
 	for ( int i = 0; i < n; ++i ) {
+		if ( rgs[i]->frozen() ) continue;
 		rgs[i]->minor_id = -1;
 	}
+
+	return used;
+}
+
+/*
+================================
+PhysicsState::rigid_sweep_rows
+
+One Projected Gauss-Seidel sweep over the specified rows
+of the island in the specified workspace (see rigid_solve_island).
+
+Frozen bodies have B = 0, and may be shared between
+threads, so their entries of a are never written.
+
+Returns the largest change in lambda.
+================================
+*/
+Scalar PhysicsState::rigid_sweep_rows( IslandWorkspace& ws, int first, int last )
+{
+	Vec3* a = ws.a.data();
+	const char* fixed = ws.fixed.data();
+	Scalar change = 0;
+
+	for ( int i = first; i < last; ++i ) {
+		int b1 = ws.map_a[i];
+		int b2 = ws.map_b[i];
+		Scalar delta = ( ws.H[i] - (
+			ws.J_a[i].dot( a[b1] ) +
+			ws.J_b[i].dot( a[b2] ) ) ) / ws.d[i];
+		Scalar L_0 = ws.L[i];
+		Scalar tmp = L_0 + delta;
+		clamp( tmp, ws.lo[i], ws.hi[i] );
+		ws.L[i] = tmp;
+		delta = ws.L[i] - L_0;
+		if ( ! fixed[b1] ) a[b1] += ws.B_a[i] * delta; // scale
+		if ( ! fixed[b2] ) a[b2] += ws.B_b[i] * delta; // scale
+		change = std::max( change, std::fabs( delta ) );
+	}
+
+	return change;
+}
+
+/*
+================================
+PhysicsState::rigid_sweep_wide
+
+Same as rigid_sweep_rows, but solves SPATIAL_SIMD_LANES rows
+at once, from the component arrays of J and B (ws.JB),
+gathering and scattering the entries of a they use.
+The specified rows must be independent (all of one color).
+
+Does the same arithmetic as rigid_sweep_rows, in the same order,
+so wide rows never change the results.
+================================
+*/
+Scalar PhysicsState::rigid_sweep_wide( IslandWorkspace& ws, int first, int last )
+{
+	int i = first;
+	Scalar change = 0;
+
+#if defined( SPATIAL_SIMD_AVX ) || defined( SPATIAL_SIMD_SSE )
+	const int W = SPATIAL_SIMD_LANES;
+	Vec3* a = ws.a.data();
+	const char* fixed = ws.fixed.data();
+	const Scalar* JB[12];
+	for ( int k = 0; k < 12; ++k ) JB[k] = ws.JB[k].data();
+
+	// a of the rows' bodies, by component
+	alignas( 32 ) Scalar g[6][ W ];
+
+	// Largest change in lambda, per lane
+#if defined( SPATIAL_SIMD_AVX )
+	const __m256 sign = _mm256_set1_ps( -0.0f );
+	__m256 changes = _mm256_setzero_ps();
+#elif defined( SPATIAL_SIMD_SSE )
+	const __m128 sign = _mm_set1_ps( -0.0f );
+	__m128 changes = _mm_setzero_ps();
+#endif
+
+	for ( ; i + W <= last; i += W ) {
+		const int* b1 = &ws.map_a[i];
+		const int* b2 = &ws.map_b[i];
+
+		// Gather
+		for ( int k = 0; k < W; ++k ) {
+			const Vec3& a1 = a[ b1[k] ];
+			const Vec3& a2 = a[ b2[k] ];
+			g[0][k] = a1.x; g[1][k] = a1.y; g[2][k] = a1.z;
+			g[3][k] = a2.x; g[4][k] = a2.y; g[5][k] = a2.z;
+		}
+
+#if defined( SPATIAL_SIMD_AVX )
+		__m256 ga[6];
+		for ( int k = 0; k < 6; ++k ) ga[k] = _mm256_load_ps( g[k] );
+
+		// J a, with the components of J_a then J_b (like Vec3::dot)
+		__m256 ja = _mm256_add_ps( _mm256_add_ps(
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[0][i] ), ga[0] ),
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[1][i] ), ga[1] ) ),
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[2][i] ), ga[2] ) );
+		__m256 jb = _mm256_add_ps( _mm256_add_ps(
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[3][i] ), ga[3] ),
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[4][i] ), ga[4] ) ),
+			_mm256_mul_ps( _mm256_loadu_ps( &JB[5][i] ), ga[5] ) );
+
+		__m256 delta = _mm256_div_ps(
+			_mm256_sub_ps( _mm256_loadu_ps( &ws.H[i] ), _mm256_add_ps( ja, jb ) ),
+			_mm256_loadu_ps( &ws.d[i] ) );
+		__m256 L_0 = _mm256_loadu_ps( &ws.L[i] );
+		__m256 tmp = _mm256_add_ps( L_0, delta );
+		tmp = _mm256_max_ps( tmp, _mm256_loadu_ps( &ws.lo[i] ) );
+		tmp = _mm256_min_ps( tmp, _mm256_loadu_ps( &ws.hi[i] ) );
+		_mm256_storeu_ps( &ws.L[i], tmp );
+		delta = _mm256_sub_ps( tmp, L_0 );
+		changes = _mm256_max_ps( changes, _mm256_andnot_ps( sign, delta ) );
+
+		// a += B delta
+		for ( int k = 0; k < 6; ++k ) {
+			__m256 b = _mm256_loadu_ps( &JB[ 6 + k ][i] );
+			_mm256_store_ps( g[k], _mm256_add_ps( ga[k], _mm256_mul_ps( b, delta ) ) );
+		}
+#elif defined( SPATIAL_SIMD_SSE )
+		__m128 ga[6];
+		for ( int k = 0; k < 6; ++k ) ga[k] = _mm_load_ps( g[k] );
+
+		// J a, with the components of J_a then J_b (like Vec3::dot)
+		__m128 ja = _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( _mm_loadu_ps( &JB[0][i] ), ga[0] ),
+			_mm_mul_ps( _mm_loadu_ps( &JB[1][i] ), ga[1] ) ),
+			_mm_mul_ps( _mm_loadu_ps( &JB[2][i] ), ga[2] ) );
+		__m128 jb = _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( _mm_loadu_ps( &JB[3][i] ), ga[3] ),
+			_mm_mul_ps( _mm_loadu_ps( &JB[4][i] ), ga[4] ) ),
+			_mm_mul_ps( _mm_loadu_ps( &JB[5][i] ), ga[5] ) );
+
+		__m128 delta = _mm_div_ps(
+			_mm_sub_ps( _mm_loadu_ps( &ws.H[i] ), _mm_add_ps( ja, jb ) ),
+			_mm_loadu_ps( &ws.d[i] ) );
+		__m128 L_0 = _mm_loadu_ps( &ws.L[i] );
+		__m128 tmp = _mm_add_ps( L_0, delta );
+		tmp = _mm_max_ps( tmp, _mm_loadu_ps( &ws.lo[i] ) );
+		tmp = _mm_min_ps( tmp, _mm_loadu_ps( &ws.hi[i] ) );
+		_mm_storeu_ps( &ws.L[i], tmp );
+		delta = _mm_sub_ps( tmp, L_0 );
+		changes = _mm_max_ps( changes, _mm_andnot_ps( sign, delta ) );
+
+		// a += B delta
+		for ( int k = 0; k < 6; ++k ) {
+			__m128 b = _mm_loadu_ps( &JB[ 6 + k ][i] );
+			_mm_store_ps( g[k], _mm_add_ps( ga[k], _mm_mul_ps( b, delta ) ) );
+		}
+#endif
+
+		// Scatter
+		for ( int k = 0; k < W; ++k ) {
+			if ( ! fixed[ b1[k] ] ) a[ b1[k] ] = Vec3( g[0][k], g[1][k], g[2][k] );
+			if ( ! fixed[ b2[k] ] ) a[ b2[k] ] = Vec3( g[3][k], g[4][k], g[5][k] );
+		}
+	}
+
+	// Horizontal maximum
+#if defined( SPATIAL_SIMD_AVX )
+	__m128 h = _mm_max_ps( _mm256_castps256_ps128( changes ), _mm256_extractf128_ps( changes, 1 ) );
+#elif defined( SPATIAL_SIMD_SSE )
+	__m128 h = changes;
+#endif
+	h = _mm_max_ps( h, _mm_movehl_ps( h, h ) );
+	h = _mm_max_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+	change = _mm_cvtss_f32( h );
+#endif
+
+	// The rest, one at a time
+	return std::max( change, rigid_sweep_rows( ws, i, last ) );
 }
 
 /*
@@ -626,20 +1297,19 @@ Detects and resolves all collisions between Euler particles and Rigid bodies.
 */
 void PhysicsState::euler_detect_rigid()
 {
-	PD_BruteForce < Euler* > pd;
 	for ( Euler* eu : eus ) {
 		if ( !eu->mask ) continue;
-		pd.insert( eu->position, eu );
+		euler_grid.insert( eu->position, eu );
 	}
 
 	for ( unsigned int i = 0; i < rigid_shapes.size(); ++i ) {
-		Rigid* rg = rigid_shapes[i].first.first;
-		// int cid = rigid_shapes[i].first.second;
-		Convex& pg = rigid_shapes[i].second;
+		Rigid* rg = rigid_shapes[i].tag.first;
+		// int cid = rigid_shapes[i].tag.second;
+		ConvexView pg = rigid_shape( i );
 
 		// Broad-phase happens here
-		for ( Euler* eu : pd.query( pg.getAABB().fatter( 2.0 ) ) ) {
-			if ( !(eu->mask & rg->mask) ) continue;
+		euler_grid.query( rigid_shapes[i].box.fatter( 2.0 ), [rg, &pg]( Euler* eu ) {
+			if ( !(eu->mask & rg->mask) ) return;
 
 			// TODO: rg->getVelocityAt( eu->position ) is more accurate
 			Vec2 bias = eu->velocity - rg->velocity;
@@ -657,7 +1327,7 @@ void PhysicsState::euler_detect_rigid()
 					eu->velocity -= eu->velocity.projection_unit( normal ) * (1+e);
 				}
 			}
-		}
+		} );
 	}
 }
 
@@ -729,6 +1399,7 @@ void PhysicsState::verlet_step()
 	verlet_find_islands();
 	verlet_detect_rigid();
 	verlet_integrate();
+	verlet_build_index();
 }
 
 /*
@@ -773,36 +1444,63 @@ void PhysicsState::verlet_integrate()
 /*
 ================================
 PhysicsState::verlet_solve_islands
+
+Islands are solved in parallel, like Rigid islands
+(see rigid_solve_islands).
 ================================
 */
 void PhysicsState::verlet_solve_islands()
 {
-	for ( VerletIsland& vli : verlet_islands ) {
-		verlet_solve_island( vli );
+	verlet_iterations = 0;
+
+	int k = verlet_islands.size();
+	island_order.clear();
+	for ( int i = 0; i < k; ++i ) {
+		int s = verlet_islands[i].second.size();
+		int cost = s * (int) std::ceil( std::sqrt( s ) );
+		island_order.push_back( std::make_pair( -cost, i ) );
 	}
+	std::sort( island_order.begin(), island_order.end() );
+
+	solver_pool.run( k, [this]( int i, int worker ) {
+		verlet_iterations += verlet_solve_island( verlet_islands[ island_order[i].second ] );
+	} );
 }
 
 /*
 ================================
 PhysicsState::verlet_solve_island
+
+Stops early once an iteration finds no Distance stretched by
+more than PHYSICS_VERLET_SOLVER_TOLERANCE (see Distance::apply).
+Returns the number of iterations used.
 ================================
 */
-void PhysicsState::verlet_solve_island( VerletIsland& vli )
+int PhysicsState::verlet_solve_island( VerletIsland& vli )
 {
 	// std::vector < Verlet* >& vls = vli.first;
 	std::vector < Distance* >& dcs = vli.second;
 
-	// Estimate the number of iterations needed
+	// Estimate the number of iterations needed (at most)
 	int m = (int) std::ceil( std::sqrt( dcs.size() ) );
+	m = std::max( m, PHYSICS_VERLET_SOLVER_MIN_ITERATIONS );
 
 	// TODO: Relax distance constraints with wall contacts.
 	// TODO: Sort constraints by PID (like we do with rigid bodies)
 
-	for ( int i = 0; i < m; ++i ) {
+	int used = 0;
+	while ( used < m ) {
+		Scalar stretch = 0;
 		for ( Distance* dc : dcs ) {
-			dc->apply();
+			stretch = std::max( stretch, dc->apply() );
 		}
+		++used;
+
+		if ( used >= PHYSICS_VERLET_SOLVER_MIN_ITERATIONS &&
+			stretch < PHYSICS_VERLET_SOLVER_TOLERANCE ) break;
 	}
+
+	return used;
 }
 
 /*
@@ -818,6 +1516,39 @@ void PhysicsState::verlet_integrate_position()
 	}
 }
 
+/*
+================================
+PhysicsState::verlet_build_index
+
+Rebuilds the index used by nearestVerlet, getVerlets and getDistances.
+================================
+*/
+void PhysicsState::verlet_build_index()
+{
+	verlet_grid.clear();
+	for ( Verlet* vl : vls ) {
+		if ( vl->pid < 0 ) continue;
+		verlet_grid.insert( vl->position, vl );
+	}
+
+	AABB bounds;
+	bool first = true;
+	for ( Distance* dc : dcs ) {
+		if ( dc->pid < 0 ) continue;
+		AABB box = dc->getAABB();
+		if ( first ) bounds = box;
+		else bounds += box;
+		first = false;
+	}
+
+	distance_quadtree.clear( bounds );
+	for ( Distance* dc : dcs ) {
+		if ( dc->pid < 0 ) continue;
+		distance_quadtree.insert( dc->getAABB(), dc );
+	}
+
+	verlet_index_dirty = false;
+}
 
 /*
 ================================
@@ -1,7 +1,9 @@
 #include "PhysicsState.h"
 #include <iostream>
+#include <algorithm> // for std::partial_sort, std::sort
 
 #include "spatial/AABB.h"
+#include "spatial/SIMD.h" // for setWideRows
 
 /*
 ================================
@@ -56,6 +58,17 @@ void PhysicsState::destroyRigid( Rigid* rg )
 	}
 	assert( rg->isolated() );
 
+	for ( int proxy : rg->proxies ) {
+		if ( proxy < 0 ) continue;
+		if ( broad_phase == BP_DYNAMIC_TREE ) rigid_tree.remove( proxy );
+		if ( broad_phase == BP_SWEEP_AND_PRUNE ) rigid_sap.remove( proxy );
+	}
+
+	// Last frame's shapes can still be queried until the next step
+	for ( auto& shape : rigid_shapes ) {
+		if ( shape.tag.first == rg ) shape.tag.first = 0;
+	}
+
 	rgs.erase( rg->it );
 	delete rg;
 }
@@ -97,10 +110,9 @@ PhysicsState::createContact( Rigid* a, Rigid* b, ContactKey& key )
 	bool cache_hit;
 	Contact* ct;
 
-	auto find = contact_cache.find( key );
-	if ( find != contact_cache.end() ) {
+	ct = contact_cache.find( key );
+	if ( ct ) {
 		cache_hit = true;
-		ct = find->second;
 	}
 	else {
 		cache_hit = false;
@@ -110,11 +122,9 @@ PhysicsState::createContact( Rigid* a, Rigid* b, ContactKey& key )
 
 		// Just for destroyContact
 		ct->key = key;
-		contact_cache[ key ] = ct;
+		contact_cache.insert( key, ct );
 	}
 
-	ct->expired = false;
-
 	return std::pair < bool, Contact* >( cache_hit, ct );
 }
 
@@ -169,6 +179,7 @@ Verlet* PhysicsState::createVerlet()
 	Verlet* vl = new Verlet();
 	vl->pid = nextPID();
 	vl->it = vls.insert( vls.end(), vl );
+	verlet_index_dirty = true;
 	return vl;
 }
 
@@ -194,6 +205,7 @@ void PhysicsState::destroyVerlet( Verlet* vl )
 
 	vls.erase( vl->it );
 	delete vl;
+	verlet_index_dirty = true;
 }
 
 /*
@@ -210,6 +222,7 @@ Distance* PhysicsState::createDistance( Verlet* a, Verlet* b )
 	Distance* dc = new Distance( a, b );
 	dc->pid = nextPID();
 	dc->it = dcs.insert( dcs.end(), dc );
+	verlet_index_dirty = true;
 	return dc;
 }
 
@@ -231,6 +244,7 @@ void PhysicsState::destroyDistance( Distance* dc )
 
 	dcs.erase( dc->it );
 	delete dc;
+	verlet_index_dirty = true;
 }
 
 /*
@@ -324,67 +338,452 @@ void PhysicsState::destroyAngular( Angular* ac )
 	delete ac;
 }
 
+/*
+================================
+PhysicsState::setBroadPhase
+
+Switches the Rigid body broad-phase algorithm.
+All persistent broad-phase data is thrown away
+(shapes are re-inserted on the next step).
+================================
+*/
+void PhysicsState::setBroadPhase( BroadPhaseType type )
+{
+	if ( type == broad_phase ) return;
+
+	for ( Rigid* rg : rgs ) {
+		rg->proxies.assign( rg->proxies.size(), -1 );
+	}
+	rigid_tree = RD_DynamicTree < int >();
+	rigid_sap = RD_SweepAndPrune < int >();
+	rigid_sap_pairs.clear();
+
+	broad_phase = type;
+}
+
+/*
+================================
+PhysicsState::setSolverThreads
+
+Sets the number of threads that solve islands (1 solves them
+on the calling thread). The results are the same either way.
+================================
+*/
+void PhysicsState::setSolverThreads( int threads )
+{
+	solver_pool.resize( threads );
+	rigid_workspaces.resize( solver_pool.size() );
+}
+
+/*
+================================
+PhysicsState::setWideRows
+
+Switches the constraint solver between one row at a time
+and several rows at once (see rigid_sweep_wide).
+Only colored islands are swept wide, and the results are the same.
+Without SIMD instructions, only one row at a time is available.
+================================
+*/
+void PhysicsState::setWideRows( bool wide )
+{
+	wide_rows = wide && SPATIAL_SIMD_LANES > 1;
+}
+
 /*
 ================================
 PhysicsState::nearestVerlet
 
 Returns the Verlet particle nearest to the specified location.
 Returns null if there are no Verlet particles within the specified radius.
-
-TODO: Make this faster?
 ================================
 */
 Verlet* PhysicsState::nearestVerlet( const Vec2& p, Scalar r )
 {
-	Verlet* ret = 0;
-	Scalar score = SCALAR_MAX;
+	std::vector < Verlet* > ret = nearestVerlets( p, r, 1 );
+	return ret.empty() ? 0 : ret.front();
+}
+
+/*
+================================
+PhysicsState::nearestVerlets
+
+Returns (at most) the k Verlet particles nearest to the specified location,
+within the specified radius, nearest first.
 
-	for ( Verlet* vl : vls ) {
-		if ( vl->frozen() ) continue;
-		if ( vl->pid < 0 ) continue;
+Ties go to the older particle.
+================================
+*/
+std::vector < Verlet* > PhysicsState::nearestVerlets( const Vec2& p, Scalar r, int k )
+{
+	if ( verlet_index_dirty ) verlet_build_index();
+
+	typedef std::pair < Scalar, Verlet* > Candidate;
+	std::vector < Candidate > candidates;
+
+	AABB box( p - Vec2( r ), p + Vec2( r ) );
+	verlet_grid.query( box.fatter( 1.0 ), [&]( Verlet* vl ) {
+		if ( vl->frozen() ) return;
+		if ( vl->pid < 0 ) return;
 		Scalar rr = (vl->position - p).length2();
-		if ( rr < score ) {
-			ret = vl;
-			score = rr;
-		}
+		if ( rr < r*r ) candidates.push_back( Candidate( rr, vl ) );
+	} );
+
+	auto nearer = []( const Candidate& a, const Candidate& b ) {
+		if ( a.first != b.first ) return a.first < b.first;
+		return a.second->pid < b.second->pid;
+	};
+	int n = std::min( k, (int) candidates.size() );
+	std::partial_sort( candidates.begin(), candidates.begin() + n, candidates.end(), nearer );
+
+	std::vector < Verlet* > ret;
+	for ( int i = 0; i < n; ++i ) {
+		ret.push_back( candidates[i].second );
 	}
-
-	return score < r*r ? ret : 0;
+	return ret;
 }
 
+/*
+================================
+PhysicsState::nearestRigid
+
+Returns the first (unfrozen) Rigid body with a shape
+containing the specified location, or null.
+
+Unlike queryPoint, there's no mask.
+================================
+*/
 Rigid* PhysicsState::nearestRigid( const Vec2& p )
 {
-	for ( auto pair : rigid_shapes ) {
-		Rigid* rg = pair.first.first;
-		Convex& c = pair.second;
-		if ( rg->frozen() ) continue;
-		if ( c.contains( p ) ) return rg;
-	}
+	std::vector < ConvexTag > tags = rigid_overlaps( AABB( p ),
+		[&p]( const ConvexTag& tag, const ConvexView& c ) {
+			return !tag.first->frozen() && c.contains( p );
+		} );
+
+	return tags.empty() ? 0 : tags.front().first;
+}
+
+/*
+================================
+PhysicsState::queryPoint
+
+Returns all Rigid body shapes containing the specified point.
+
+The query* functions only report Rigid bodies sharing a bit
+with the specified mask, in the order of rigid_shapes.
+They use last frame's shapes and broad-phase.
+================================
+*/
+std::vector < PhysicsState::ConvexTag >
+PhysicsState::queryPoint( const Vec2& p, PhysicsMask mask )
+{
+	return rigid_overlaps( AABB( p ), [&]( const ConvexTag& tag, const ConvexView& c ) {
+		return (tag.first->mask & mask) && c.contains( p );
+	} );
+}
+
+/*
+================================
+PhysicsState::queryAABB
+
+Returns all Rigid body shapes intersecting the specified box.
+================================
+*/
+std::vector < PhysicsState::ConvexTag >
+PhysicsState::queryAABB( const AABB& box, PhysicsMask mask )
+{
+	return rigid_overlaps( box, [&]( const ConvexTag& tag, const ConvexView& c ) {
+		if ( !(tag.first->mask & mask) ) return false;
+
+		// Separating axes: the box axes...
+		AABB cbox = c.getAABB();
+		if ( cbox.max.x < box.min.x || box.max.x < cbox.min.x ) return false;
+		if ( cbox.max.y < box.min.y || box.max.y < cbox.min.y ) return false;
+
+		// ...and the polygon normals
+		Vec2 corners[4] = {
+			box.min, Vec2( box.max.x, box.min.y ),
+			box.max, Vec2( box.min.x, box.max.y ) };
+		int n = c.points.size();
+		for ( int i = 0; i < n; ++i ) {
+			Wall ref( c.points[i], c.normals[i] );
+			Scalar min_box = SCALAR_MAX;
+			for ( const Vec2& v : corners ) {
+				min_box = std::min( min_box, ref.distance( v ) );
+			}
+			if ( 0 < min_box ) return false;
+		}
+		return true;
+	} );
+}
 
-	return 0;
+/*
+================================
+PhysicsState::queryConvex
+
+Returns all Rigid body shapes intersecting the specified polygon.
+================================
+*/
+std::vector < PhysicsState::ConvexTag >
+PhysicsState::queryConvex( const Convex& c, PhysicsMask mask )
+{
+	return rigid_overlaps( c.getAABB(), [&]( const ConvexTag& tag, const ConvexView& d ) {
+		return (tag.first->mask & mask) && Convex::sat( c, d ).first;
+	} );
 }
 
 // Returns all Verlet particles contained by the specified box.
 std::list < Verlet * > PhysicsState::getVerlets( const AABB& box ) {
+	if ( verlet_index_dirty ) verlet_build_index();
+
 	std::list < Verlet *> results;
-	for ( Verlet* vl : vls ) {
-		if ( vl->frozen() ) continue;
-		if ( vl->pid < 0 ) continue;
+	// Grid queries contain points; AABB::intersects has some slop
+	verlet_grid.query( box.fatter( 2.0 ), [&]( Verlet* vl ) {
+		if ( vl->frozen() ) return;
+		if ( vl->pid < 0 ) return;
 		if ( box.intersects( vl->getAABB() ) ) {
 			results.push_back( vl );
 		}
-	}
+	} );
 	return results;
 }
 
 // Returns all Distance constraints intersecting the specified box.
 std::list < Distance * > PhysicsState::getDistances( const AABB& box ) {
+	if ( verlet_index_dirty ) verlet_build_index();
+
 	std::list < Distance *> results;
-	for ( Distance* dc : dcs ) {
-		if ( dc->pid < 0 ) continue;
-		if ( box.intersects( dc->getAABB() ) ) {
-			results.push_back( dc );
+	distance_quadtree.query( box, [&]( Distance* dc ) {
+		if ( dc->pid < 0 ) return;
+		results.push_back( dc );
+	} );
+	return results;
+}
+
+/*
+================================
+PhysicsState::raycast
+
+Returns the first hit on a Rigid body shape
+along the part of the specified ray with t in [ 0, t_max ].
+
+Only Rigid bodies sharing a bit with the specified mask are hit.
+Rays starting inside a shape don't hit that shape.
+
+Uses last frame's shapes and broad-phase.
+================================
+*/
+std::pair < bool, RaycastHit >
+PhysicsState::raycast( const Ray& ray, Scalar t_max, PhysicsMask mask )
+{
+	std::pair < bool, RaycastHit > ret;
+	ret.first = false;
+	int best = -1;
+
+	rigid_query( ray, t_max, [&]( int i ) {
+		Scalar clip = ret.first ? ret.second.t : t_max;
+		if ( !(rigid_shapes[i].tag.first->mask & mask) ) return clip;
+
+		auto hit = rigid_raycast_shape( i, ray, clip );
+		if ( !hit.first ) return clip;
+
+		// Break ties by shape order, so the result doesn't
+		// depend on the order of the broad-phase traversal
+		bool nearer = !ret.first || hit.second.t < ret.second.t;
+		bool tied = ret.first && hit.second.t == ret.second.t;
+		if ( nearer || ( tied && i < best ) ) {
+			ret = hit;
+			best = i;
+		}
+		return ret.second.t;
+	} );
+
+	return ret;
+}
+
+/*
+================================
+PhysicsState::raycastAll
+
+Returns every hit on a Rigid body shape
+along the part of the specified ray with t in [ 0, t_max ],
+nearest first (at most one hit per shape).
+================================
+*/
+std::vector < RaycastHit >
+PhysicsState::raycastAll( const Ray& ray, Scalar t_max, PhysicsMask mask )
+{
+	std::vector < std::pair < int, RaycastHit > > hits;
+
+	rigid_query( ray, t_max, [&]( int i ) {
+		if ( !(rigid_shapes[i].tag.first->mask & mask) ) return t_max;
+
+		auto hit = rigid_raycast_shape( i, ray, t_max );
+		if ( hit.first ) {
+			hits.push_back( std::pair < int, RaycastHit >( i, hit.second ) );
 		}
+		return t_max;
+	} );
+
+	std::sort( hits.begin(), hits.end(),
+		[]( const std::pair < int, RaycastHit >& a, const std::pair < int, RaycastHit >& b ) {
+			if ( a.second.t != b.second.t ) return a.second.t < b.second.t;
+			return a.first < b.first;
+		} );
+
+	std::vector < RaycastHit > ret;
+	for ( auto& hit : hits ) {
+		ret.push_back( hit.second );
 	}
-	return results;
+	return ret;
+}
+
+/*
+================================
+PhysicsState::segmentCast
+
+Same as raycast, from the first point of the specified segment
+to the second point (t goes from 0 to 1).
+================================
+*/
+std::pair < bool, RaycastHit >
+PhysicsState::segmentCast( const Segment& seg, PhysicsMask mask )
+{
+	return raycast( Ray( seg.first, seg.second - seg.first ), 1, mask );
+}
+
+/*
+================================
+PhysicsState::segmentCastAll
+================================
+*/
+std::vector < RaycastHit >
+PhysicsState::segmentCastAll( const Segment& seg, PhysicsMask mask )
+{
+	return raycastAll( Ray( seg.first, seg.second - seg.first ), 1, mask );
+}
+
+/*
+================================
+PhysicsState::rigid_query (overloaded)
+
+Calls visit( i ) for each shape in rigid_shapes
+whose broad-phase box intersects the specified AABB.
+
+Skips shapes of Rigid bodies destroyed since the last step.
+================================
+*/
+template < typename F >
+void PhysicsState::rigid_query( const AABB& box, F&& visit )
+{
+	auto live = [&]( int i ) {
+		if ( i >= (int) rigid_shapes.size() ) return;
+		if ( !rigid_shapes[i].tag.first ) return;
+		visit( i );
+	};
+
+	switch ( broad_phase )
+	{
+	case BP_BRUTE_FORCE: rigid_brute_force.query( box, live ); break;
+	case BP_DYNAMIC_TREE: rigid_tree.query( box, live ); break;
+	case BP_SWEEP_AND_PRUNE: rigid_sap.query( box, live ); break;
+	case BP_QUADTREE: rigid_quadtree.query( box, live ); break;
+	}
+}
+
+/*
+================================
+PhysicsState::rigid_query (overloaded)
+
+Calls visit( i ) for each shape in rigid_shapes
+whose broad-phase box is hit by the part of
+the specified ray with t in [ 0, t_max ].
+
+visit returns the new t_max (see RD_DynamicTree::raycast).
+Only the dynamic tree can follow the ray;
+the other algorithms query the box around the ray.
+================================
+*/
+template < typename F >
+void PhysicsState::rigid_query( const Ray& ray, Scalar t_max, F&& visit )
+{
+	if ( broad_phase != BP_DYNAMIC_TREE ) {
+		AABB box = AABB( ray.origin ) + AABB( ray.at( t_max ) );
+		rigid_query( box, [&]( int i ) {
+			if ( !ray.intersects( rigid_shapes[i].box, t_max ) ) return;
+			t_max = visit( i );
+		} );
+		return;
+	}
+
+	rigid_tree.raycast( ray, t_max, [&]( int i ) {
+		if ( i >= (int) rigid_shapes.size() ) return t_max;
+		if ( !rigid_shapes[i].tag.first ) return t_max;
+		t_max = visit( i );
+		return t_max;
+	} );
+}
+
+/*
+================================
+PhysicsState::rigid_raycast_shape
+
+Returns the hit of the specified ray on the specified shape
+(the first edge the ray enters through, with t in [ 0, t_max ]).
+================================
+*/
+std::pair < bool, RaycastHit >
+PhysicsState::rigid_raycast_shape( int i, const Ray& ray, Scalar t_max )
+{
+	std::pair < bool, RaycastHit > ret;
+	ret.first = false;
+
+	ConvexView c = rigid_shape( i );
+	int n = c.points.size();
+	for ( int k = 0; k < n; ++k ) {
+		// Only edges facing the ray
+		if ( ray.direction * c.normals[k] >= 0 ) continue;
+
+		Segment edge( c.points[k], c.points[ (k+1) % n ] );
+		auto hit = ray.intersects( edge );
+		if ( !hit.first ) continue;
+		if ( hit.second > t_max ) continue;
+		if ( ret.first && hit.second >= ret.second.t ) continue;
+
+		ret.first = true;
+		ret.second.rg = rigid_shapes[i].tag.first;
+		ret.second.cid = rigid_shapes[i].tag.second;
+		ret.second.eid = k;
+		ret.second.point = ray.at( hit.second );
+		ret.second.normal = c.normals[k];
+		ret.second.t = hit.second;
+	}
+
+	return ret;
+}
+
+/*
+================================
+PhysicsState::rigid_overlaps
+
+Returns the shapes (in the order of rigid_shapes) whose
+broad-phase box intersects the specified box,
+and for which overlaps( tag, shape ) returns true.
+================================
+*/
+template < typename P >
+std::vector < PhysicsState::ConvexTag >
+PhysicsState::rigid_overlaps( const AABB& box, P&& overlaps )
+{
+	std::vector < int > is;
+	rigid_query( box, [&]( int i ) {
+		if ( overlaps( rigid_shapes[i].tag, rigid_shape( i ) ) ) is.push_back( i );
+	} );
+	std::sort( is.begin(), is.end() );
+
+	std::vector < ConvexTag > ret;
+	for ( int i : is ) {
+		ret.push_back( rigid_shapes[i].tag );
+	}
+	return ret;
 }
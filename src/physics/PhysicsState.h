@@ -1,11 +1,14 @@
 #ifndef PHYSICS_STATE_H
 #define PHYSICS_STATE_H
 
+#include <atomic> // for solver iteration counts
+#include <cstdint> // for uint64_t
 #include <list>
 #include <vector>
 #include <unordered_map>
 #include "game/BlankState.h" // superclass BlankState
 #include "common/MeshOBJ.h"
+#include "common/WorkerPool.h"
 #include "Constants.h"
 #include "PhysicsTags.h"
 #include "PhysicsGraph.h"
@@ -13,10 +16,53 @@
 #include "Rigid.h"
 #include "Constraint.h"
 #include "Contact.h"
+#include "ContactTable.h"
 #include "Friction.h"
 #include "Verlet.h"
 #include "Distance.h"
 #include "Angular.h"
+#include "spatial/RD_BruteForce.h"
+#include "spatial/RD_DynamicTree.h"
+#include "spatial/RD_SweepAndPrune.h"
+#include "spatial/RD_Quadtree.h"
+#include "spatial/PD_HashGrid.h"
+#include "spatial/Ray.h"
+#include "spatial/Segment.h"
+
+/*
+================================
+Enumerates the broad-phase algorithms
+available for Rigid body collision detection:
+"brute force": tests every pair (rebuilt every frame)
+"dynamic tree": a persistent tree of fattened boxes
+"sweep and prune": persistent sorted endpoint lists
+"quadtree": a loose quadtree (rebuilt every frame)
+
+NOTE: The quadtree is opt-in only (no scene selects it).
+With one huge box among many small ones (see spatial-bench)
+it beats the dynamic tree, but sweep and prune beats both.
+================================
+*/
+enum BroadPhaseType
+	{ BP_BRUTE_FORCE, BP_DYNAMIC_TREE, BP_SWEEP_AND_PRUNE, BP_QUADTREE };
+
+/*
+================================
+A ray (or segment) hit on a Rigid body shape.
+
+The hit point is ray.at( t ), on edge eid
+(from point eid to point eid+1) of shape cid.
+================================
+*/
+struct RaycastHit
+{
+	Rigid* rg;
+	int cid; // shape index
+	int eid; // edge index
+	Vec2 point;
+	Vec2 normal;
+	Scalar t;
+};
 
 /*
 ================================
@@ -44,7 +90,15 @@ public: // State implementation
 public: // Singleton pattern
 	static PhysicsState* Instance();
 protected:
-	PhysicsState() {}
+	PhysicsState() :
+		rigid_workspaces( 1 ),
+		wide_rows( false ),
+		rigid_iterations( 0 ),
+		verlet_iterations( 0 ),
+		broad_phase( BP_DYNAMIC_TREE ),
+		euler_grid( PHYSICS_EULER_GRID_CELL ),
+		verlet_grid( PHYSICS_VERLET_GRID_CELL ),
+		verlet_index_dirty( true ) {}
 
 public: // Physics engine - lifecycle
 	Rigid* createRigid( const MeshOBJ& obj );
@@ -66,13 +120,44 @@ public: // Physics engine - lifecycle
 	Angular* createAngular( Distance* m, Distance* n );
 	void destroyAngular( Angular* ac );
 
+public: // Physics engine - settings
+	void setBroadPhase( BroadPhaseType type );
+	BroadPhaseType getBroadPhase() const { return broad_phase; }
+	void setSolverThreads( int threads );
+	int getSolverThreads() const { return solver_pool.size(); }
+	void setWideRows( bool wide );
+	bool getWideRows() const { return wide_rows; }
+
 public: // Physics engine - stuff
+	// A Rigid body shape: ( body, shape index )
+	typedef std::pair < Rigid*, int > ConvexTag;
+
 	Verlet* nearestVerlet( const Vec2& p, Scalar r );
+	std::vector < Verlet* > nearestVerlets( const Vec2& p, Scalar r, int k );
 	Rigid* nearestRigid( const Vec2& p );
 
 	std::list < Verlet * > getVerlets( const AABB& box );
 	std::list < Distance * > getDistances( const AABB& box );
 
+	std::vector < ConvexTag > queryPoint( const Vec2& p, PhysicsMask mask );
+	std::vector < ConvexTag > queryAABB( const AABB& box, PhysicsMask mask );
+	std::vector < ConvexTag > queryConvex( const Convex& c, PhysicsMask mask );
+
+public: // Physics engine - casts
+	std::pair < bool, RaycastHit > raycast( const Ray& ray, Scalar t_max, PhysicsMask mask );
+	std::vector < RaycastHit > raycastAll( const Ray& ray, Scalar t_max, PhysicsMask mask );
+	std::pair < bool, RaycastHit > segmentCast( const Segment& seg, PhysicsMask mask );
+	std::vector < RaycastHit > segmentCastAll( const Segment& seg, PhysicsMask mask );
+
+private: // Physics engine - queries
+	template < typename F >
+	void rigid_query( const AABB& box, F&& visit );
+	template < typename F >
+	void rigid_query( const Ray& ray, Scalar t_max, F&& visit );
+	std::pair < bool, RaycastHit > rigid_raycast_shape( int i, const Ray& ray, Scalar t_max );
+	template < typename P >
+	std::vector < ConvexTag > rigid_overlaps( const AABB& box, P&& overlaps );
+
 	// RigidIsland island( Rigid* rg );
 	// VerletIsland island( Verlet* vl );
 
@@ -80,9 +165,6 @@ private: // Physics timestep
 	std::pair < bool, Contact* > createContact( Rigid* a, Rigid* b, ContactKey& key );
 	void destroyContact( Contact* ct );
 
-	std::list < Contact* > contacts();
-
-	typedef std::pair < Rigid*, int > ConvexTag;
 	typedef PhysicsGraph < Rigid, Constraint >::Island RigidIsland;
 	typedef PhysicsGraph < Verlet, Distance >::Island VerletIsland;
 
@@ -91,10 +173,24 @@ private: // Physics timestep
 
 		void rigid_step();
 			void rigid_transform_convex();
+			ConvexView rigid_shape( int i ) const;
 			void rigid_detect_rigid();
+				void rigid_broad_phase();
+				template < typename RD >
+				void rigid_update_proxies( RD& rd );
 				void rigid_caltrops(
-					ConvexTag& ta, Convex& a,
-					ConvexTag& tb, Convex& b );
+					const ConvexTag& ta, const ConvexView& a,
+					const ConvexTag& tb, const ConvexView& b );
+				void rigid_fire_caltrops(
+					const ConvexView& r, const ConvexView& in,
+					const Vec2& u, Scalar length,
+					const Wall& wy, const Wall& wx, bool flip );
+				struct Manifold;
+				void rigid_reduce_manifold( Manifold& m );
+				void rigid_contact(
+					const ConvexTag& tr, const ConvexView& r, int ir,
+					const ConvexTag& ti, const ConvexView& in, int ii );
+			void rigid_expire_manifolds();
 			void rigid_expire_contacts();
 			void rigid_find_islands();
 				// RigidGraph mark_connected( Rigid* root );
@@ -103,7 +199,10 @@ private: // Physics timestep
 					void rigid_apply_gravity_forces();
 					void rigid_apply_wind_forces();
 					void rigid_solve_islands();
-						void rigid_solve_island( RigidIsland& rgi );
+						struct IslandWorkspace;
+						int rigid_solve_island( RigidIsland& rgi, IslandWorkspace& ws, bool parallel );
+							Scalar rigid_sweep_rows( IslandWorkspace& ws, int first, int last );
+							Scalar rigid_sweep_wide( IslandWorkspace& ws, int first, int last );
 				void rigid_integrate_position();
 
 		void euler_step();
@@ -120,8 +219,9 @@ private: // Physics timestep
 			void verlet_detect_rigid();
 			void verlet_integrate();
 				void verlet_solve_islands();
-					void verlet_solve_island( VerletIsland& vli );
+					int verlet_solve_island( VerletIsland& vli );
 				void verlet_integrate_position();
+			void verlet_build_index();
 
 	int nextPID();
 
@@ -134,11 +234,109 @@ private: // Members
 	std::list < Constraint* > cts;
 	std::vector < PhysicsGraph < Rigid, Constraint >::Island > rigid_islands;
 
-	std::vector < std::pair < ConvexTag, Convex > > rigid_shapes;
-	std::unordered_map < ContactKey, Contact* > contact_cache;
+	// Solver state of one Rigid island (see rigid_solve_island),
+	// kept between islands and frames so solving doesn't allocate.
+	// Per body: V, M, a, F. Per constraint row: everything else,
+	// with the two halves of J and B (= M J) in separate arrays.
+	struct IslandWorkspace
+	{
+		std::vector < Vec3 > V, M, a, F;
+		std::vector < char > fixed; // frozen
+		std::vector < Vec3 > J_a, J_b, B_a, B_b;
+		std::vector < int > map_a, map_b;
+		std::vector < Scalar > H, d, L, lo, hi;
+
+		// Coloring (big islands only): constraints of color c
+		// are rows colors[c] to colors[c+1] (64 is the leftovers)
+		std::vector < int > colors;
+		std::vector < uint64_t > body_colors; // colors used, per body
+		std::vector < int > row_colors;
+		std::vector < Constraint* > rows; // sorting scratch
+
+		// Wide rows (colored islands only): x, y, z of J_a, J_b, B_a, B_b
+		std::vector < Scalar > JB[12];
+
+		// Largest change in lambda per thread, for the
+		// last two iterations (parallel solving only)
+		std::vector < Scalar > changes;
+	};
+	std::vector < IslandWorkspace > rigid_workspaces; // one per solver thread
+
+	// Island solving (see rigid_solve_islands)
+	WorkerPool solver_pool;
+	bool wide_rows; // see rigid_sweep_wide
+	// Solver iterations used last step, summed over islands
+	std::atomic < int > rigid_iterations, verlet_iterations;
+	std::vector < std::pair < int, int > > island_order; // ( -cost, island )
+
+	// World-space shapes for this frame, stored flat:
+	// shape i's points and normals start at rigid_shapes[i].offset
+	// in the point buffers, and are padded like its structure of arrays
+	struct RigidShape
+	{
+		ConvexTag tag;
+		int offset;
+		int count; // number of points
+		int padded; // number of points, padded (see Convex::refresh)
+		AABB box; // bounds of the shape
+		Vec2 center; // bounding circle of the shape
+		Scalar radius;
+	};
+	std::vector < RigidShape > rigid_shapes;
+	std::vector < Vec2 > rigid_points, rigid_normals;
+	std::vector < Scalar > rigid_xs, rigid_ys;
+	std::vector < AABB > rigid_boxes; // broad-phase box of each rigid shape
+	std::vector < std::pair < int, int > > rigid_pairs; // broad-phase output
+	std::vector < int > rigid_candidates; // broad-phase query scratch
+
+	// Broad-phase (the integers index rigid_shapes)
+	BroadPhaseType broad_phase;
+	RD_BruteForce < int > rigid_brute_force;
+	RD_DynamicTree < int > rigid_tree;
+	RD_SweepAndPrune < int > rigid_sap;
+	// Overlapping SAP proxies ( hi, lo ), kept sorted from its pair events
+	std::vector < std::pair < int, int > > rigid_sap_pairs;
+	std::vector < std::pair < int, int > > rigid_sap_added, rigid_sap_removed, rigid_sap_scratch;
+	RD_Quadtree < int > rigid_quadtree;
+	ContactTable contact_cache;
+
+	// Narrow-phase state of each shape pair
+	// that reached the narrow phase last frame
+	struct ManifoldPoint
+	{
+		bool flip; // B is the reference shape
+		int ir; // reference edge
+		int ii; // incident vertex
+	};
+	struct Manifold
+	{
+		Manifold() : axis( -1 ), expired( false ), position( 0 ), angle( 0 ) {}
+
+		int axis; // last separating (or minimum overlap) axis, see Convex::sat
+		bool expired;
+
+		// Relative transform of B in A's frame,
+		// and the contacts kept, at the last full narrow phase
+		Vec2 position;
+		Scalar angle;
+		SmallVector < ManifoldPoint, 8 > points;
+	};
+	std::unordered_map < ShapePairKey, Manifold > manifolds;
+
+	// Caltrop hits of the current shape pair (see rigid_reduce_manifold)
+	struct CaltropHit
+	{
+		ManifoldPoint mp;
+		Scalar depth;
+		Vec2 p; // incident vertex
+		bool kept; // already in the manifold
+		bool chosen; // by this reduction
+	};
+	std::vector < CaltropHit > rigid_hits;
 
 	// Euler particles
 	std::list < Euler* > eus;
+	PD_HashGrid < Euler* > euler_grid; // refilled every frame
 
 	// Verlet particles
 	std::list < Verlet* > vls;
@@ -146,6 +344,12 @@ private: // Members
 	std::list < Angular* > acs;
 	std::vector < PhysicsGraph < Verlet, Distance >::Island > verlet_islands;
 
+	// Index for the public Verlet/Distance queries
+	// (rebuilt every step, and after any Verlet or Distance is created or destroyed)
+	PD_HashGrid < Verlet* > verlet_grid;
+	RD_Quadtree < Distance* > distance_quadtree;
+	bool verlet_index_dirty;
+
 	friend class Contact;
 };
 
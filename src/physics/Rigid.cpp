@@ -3,6 +3,7 @@
 #include "Constants.h"
 #include "spatial/AABB.h"
 #include "game/InputSet.h"
+#include <algorithm> // for std::max
 
 /*
 ================================
@@ -25,7 +26,11 @@ Rigid::Rigid() :
 	mass( STANDARD_MASS ),
 	moment( STANDARD_MOMENT ),
 	bounce( STANDARD_BOUNCE ),
-	friction( STANDARD_FRICTION )
+	friction( STANDARD_FRICTION ),
+	// World-space shapes
+	world_angle( 0 ),
+	world_cos( 1 ), world_sin( 0 ),
+	world_valid( false )
 {
 	
 }
@@ -45,6 +50,9 @@ Rigid::Rigid( const std::vector < Convex >& cs ) :
 
 	int n = shapes.size();
 
+	// Not in the broad-phase yet
+	proxies.assign( n, -1 );
+
 	// Compute convex properties
 	// Save data for aggregate calculations
 	std::vector < Scalar > masses(n);
@@ -87,6 +95,17 @@ Rigid::Rigid( const std::vector < Convex >& cs ) :
 	for ( int i = 0; i < n; ++i ) {
 		shapes[i].translate( -position );
 	}
+
+	// Bounding circles, around the center of each shape's box
+	for ( int i = 0; i < n; ++i ) {
+		Vec2 center = shapes[i].getAABB().center();
+		Scalar radius = 0;
+		for ( const Vec2& p : shapes[i].points ) {
+			radius = std::max( radius, (p - center).length() );
+		}
+		centers.push_back( center );
+		radii.push_back( radius + PHYSICS_BOUNDING_CIRCLE_SLOP );
+	}
 }
 
 /*
@@ -163,8 +182,9 @@ Rigid::getAABB
 Returns a bounding box containing all the bounding boxes
 of the Convex shapes that make up this Rigid, in world space.
 
-Expensive. In the process,
-the world transform of each shape is computed, then discarded.
+Cheap if the body hasn't moved since the last step
+(the world-space bounds are cached, see update_world_shapes).
+Otherwise, the world transform of each shape is computed, then discarded.
 ================================
 */
 AABB Rigid::getAABB() const
@@ -175,9 +195,18 @@ AABB Rigid::getAABB() const
 	// PhysicsState::createRigid).
 	AABB box( position );
 
+	int n = shapes.size();
+	if ( world_valid &&
+		world_position == position &&
+		world_angle == angular_position ) {
+		for ( int i = 0; i < n; ++i ) {
+			box += world_boxes[i];
+		}
+		return box;
+	}
+
 	// TODO (convex concept):
 	// The plus operator is planned to become the Minkowski Sum.
-	int n = shapes.size();
 	for ( int i = 0; i < n; ++i ) {
 		Convex c( shapes[i] );
 		c.transform( position, angular_position );
@@ -186,6 +215,46 @@ AABB Rigid::getAABB() const
 	return box;
 }
 
+/*
+================================
+Rigid::update_world_shapes
+
+Transforms the shapes (and their bounds) into world space,
+unless the body hasn't moved since the last call
+(so frozen bodies are only transformed once).
+================================
+*/
+void Rigid::update_world_shapes()
+{
+	if ( world_valid &&
+		world_position == position &&
+		world_angle == angular_position ) return;
+
+	// One rotation for all shapes
+	Scalar cos = std::cos( angular_position );
+	Scalar sin = std::sin( angular_position );
+
+	// Assignment keeps the copies' storage
+	int n = shapes.size();
+	if ( (int) world_shapes.size() != n ) {
+		world_shapes = shapes;
+		world_boxes.resize( n );
+		world_centers.resize( n );
+	}
+	for ( int i = 0; i < n; ++i ) {
+		world_shapes[i] = shapes[i];
+		world_shapes[i].transform( position, cos, sin );
+		world_boxes[i] = world_shapes[i].getAABB();
+		world_centers[i] = centers[i].rotation( cos, sin ) + position;
+	}
+
+	world_position = position;
+	world_angle = angular_position;
+	world_cos = cos;
+	world_sin = sin;
+	world_valid = true;
+}
+
 Vec2 Rigid::world( const Vec2& l ) const
 {
 	return position + l.rotation( angular_position );
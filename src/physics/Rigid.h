@@ -7,8 +7,8 @@
 #include "spatial/Vec2.h"
 #include "spatial/Vec3.h"
 #include "spatial/Convex.h"
+#include "spatial/AABB.h" // for std::vector < AABB >
 
-class AABB;
 class InputSet;
 class Constraint;
 
@@ -90,8 +90,26 @@ public: // Members
 		bounce,
 		friction;
 
+private: // Functions
+	void update_world_shapes();
+
 private: // Members
 	std::vector < Convex > shapes; // object space
+	std::vector < int > proxies; // broad-phase proxy of each shape
+
+	// Bounding circle of each shape (object space)
+	std::vector < Vec2 > centers;
+	std::vector < Scalar > radii;
+
+	// World-space copies of the shapes, their bounds
+	// and bounding circle centers (see update_world_shapes)
+	std::vector < Convex > world_shapes;
+	std::vector < AABB > world_boxes;
+	std::vector < Vec2 > world_centers;
+	Vec2 world_position;
+	Scalar world_angle;
+	Scalar world_cos, world_sin; // of world_angle
+	bool world_valid;
 
 	// TODO: Maybe this can move into PhysicsTags (CRTP)?
 	std::list < Rigid* >::iterator it;
@@ -0,0 +1,79 @@
+#include "AABBArray.h"
+#include <limits> // for std::numeric_limits
+
+/*
+================================
+AABBArray::AABBArray
+================================
+*/
+AABBArray::AABBArray() :
+	n( 0 )
+{
+
+}
+
+/*
+================================
+AABBArray::clear
+
+Removes all boxes, but keeps all storage.
+================================
+*/
+void AABBArray::clear()
+{
+	min_x.clear();
+	min_y.clear();
+	max_x.clear();
+	max_y.clear();
+	n = 0;
+}
+
+/*
+================================
+AABBArray::push_back
+================================
+*/
+void AABBArray::push_back( const AABB& box )
+{
+	// Start a new block of empty boxes
+	// (an empty box has min = +inf and max = -inf)
+	if ( n % LANES == 0 ) {
+		const Scalar inf = std::numeric_limits < Scalar >::infinity();
+		min_x.resize( n + LANES, inf );
+		min_y.resize( n + LANES, inf );
+		max_x.resize( n + LANES, -inf );
+		max_y.resize( n + LANES, -inf );
+	}
+
+	min_x[n] = box.min.x;
+	min_y[n] = box.min.y;
+	max_x[n] = box.max.x;
+	max_y[n] = box.max.y;
+	++n;
+}
+
+/*
+================================
+AABBArray::operator []
+================================
+*/
+AABB AABBArray::operator [] ( int i ) const
+{
+	return AABB( Vec2( min_x[i], min_y[i] ), Vec2( max_x[i], max_y[i] ) );
+}
+
+/*
+================================
+AABBArray::find_all_pairs (overloaded)
+
+Fills the specified buffer with all pairs of intersecting boxes
+(the buffer keeps its storage between calls).
+================================
+*/
+void AABBArray::find_all_pairs( std::vector < std::pair < int, int > >& out ) const
+{
+	out.clear();
+	find_all_pairs( [&out]( int i, int j ) {
+		out.push_back( std::pair < int, int >( i, j ) );
+	} );
+}
@@ -0,0 +1,156 @@
+#ifndef SPATIAL_AABB_ARRAY_H
+#define SPATIAL_AABB_ARRAY_H
+
+#include <vector>
+#include "AABB.h"
+#include "SIMD.h"
+
+/*
+================================
+AABBArray
+
+A list of AABBs stored as a structure of arrays
+(separate min x, min y, max x and max y arrays),
+so one box can be tested against several at once:
+8 per instruction with AVX, 4 with SSE,
+or one at a time without either.
+
+The overlap test gives exactly the same results as AABB::intersects
+(the same operations in the same order, lane by lane).
+
+The arrays are padded to a multiple of the lane count
+with empty boxes, which never overlap anything.
+================================
+*/
+class AABBArray
+{
+public:
+	static const int LANES = SPATIAL_SIMD_LANES;
+
+public:
+	AABBArray();
+	~AABBArray() {}
+
+	void clear();
+	void push_back( const AABB& box );
+
+	int size() const { return n; }
+	AABB operator [] ( int i ) const;
+
+	template < typename F >
+	void query( const AABB& box, F&& visit ) const;
+
+	void find_all_pairs( std::vector < std::pair < int, int > >& out ) const;
+	template < typename F >
+	void find_all_pairs( F&& visit ) const;
+
+private: // Functions
+	unsigned int overlaps( const AABB& box, int base ) const;
+
+private: // Members
+	std::vector < Scalar > min_x, min_y, max_x, max_y;
+	int n;
+};
+
+/*
+================================
+AABBArray::query
+
+Calls visit( i ) for each box i that intersects the specified AABB,
+in increasing order.
+================================
+*/
+template < typename F >
+void AABBArray::query( const AABB& box, F&& visit ) const
+{
+	for ( int base = 0; base < n; base += LANES ) {
+		unsigned int mask = overlaps( box, base );
+		for ( int k = 0; mask; ++k, mask >>= 1 ) {
+			if ( mask & 1 ) visit( base + k );
+		}
+	}
+}
+
+/*
+================================
+AABBArray::find_all_pairs (overloaded)
+
+Calls visit( i, j ) for each pair of intersecting boxes, with j < i,
+in increasing order of i, then j (the order of an insert-after-query loop).
+================================
+*/
+template < typename F >
+void AABBArray::find_all_pairs( F&& visit ) const
+{
+	for ( int i = 1; i < n; ++i ) {
+		AABB box = (*this)[i];
+		for ( int base = 0; base < i; base += LANES ) {
+			unsigned int mask = overlaps( box, base );
+			// Only lanes before i
+			if ( i - base < LANES ) mask &= ( 1u << ( i - base ) ) - 1;
+			for ( int k = 0; mask; ++k, mask >>= 1 ) {
+				if ( mask & 1 ) visit( i, base + k );
+			}
+		}
+	}
+}
+
+/*
+================================
+AABBArray::overlaps
+
+Returns a bitmask of the boxes base .. base + LANES - 1
+that intersect the specified AABB.
+
+Same as AABB::intersects (Minkowski difference with a slop of 1.0).
+================================
+*/
+inline unsigned int AABBArray::overlaps( const AABB& box, int base ) const
+{
+#if defined( SPATIAL_SIMD_AVX )
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 slop = _mm256_set1_ps( 1.0f );
+
+	__m256 lo_x = _mm256_sub_ps( _mm256_sub_ps(
+		_mm256_set1_ps( box.min.x ), _mm256_loadu_ps( &max_x[ base ] ) ), slop );
+	__m256 lo_y = _mm256_sub_ps( _mm256_sub_ps(
+		_mm256_set1_ps( box.min.y ), _mm256_loadu_ps( &max_y[ base ] ) ), slop );
+	__m256 hi_x = _mm256_add_ps( _mm256_sub_ps(
+		_mm256_set1_ps( box.max.x ), _mm256_loadu_ps( &min_x[ base ] ) ), slop );
+	__m256 hi_y = _mm256_add_ps( _mm256_sub_ps(
+		_mm256_set1_ps( box.max.y ), _mm256_loadu_ps( &min_y[ base ] ) ), slop );
+
+	// The difference box contains the origin (semiclosed)
+	__m256 in = _mm256_and_ps(
+		_mm256_and_ps(
+			_mm256_cmp_ps( lo_x, zero, _CMP_LE_OQ ),
+			_mm256_cmp_ps( lo_y, zero, _CMP_LE_OQ ) ),
+		_mm256_and_ps(
+			_mm256_cmp_ps( zero, hi_x, _CMP_LT_OQ ),
+			_mm256_cmp_ps( zero, hi_y, _CMP_LT_OQ ) ) );
+	return _mm256_movemask_ps( in );
+#elif defined( SPATIAL_SIMD_SSE )
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 slop = _mm_set1_ps( 1.0f );
+
+	__m128 lo_x = _mm_sub_ps( _mm_sub_ps(
+		_mm_set1_ps( box.min.x ), _mm_loadu_ps( &max_x[ base ] ) ), slop );
+	__m128 lo_y = _mm_sub_ps( _mm_sub_ps(
+		_mm_set1_ps( box.min.y ), _mm_loadu_ps( &max_y[ base ] ) ), slop );
+	__m128 hi_x = _mm_add_ps( _mm_sub_ps(
+		_mm_set1_ps( box.max.x ), _mm_loadu_ps( &min_x[ base ] ) ), slop );
+	__m128 hi_y = _mm_add_ps( _mm_sub_ps(
+		_mm_set1_ps( box.max.y ), _mm_loadu_ps( &min_y[ base ] ) ), slop );
+
+	// The difference box contains the origin (semiclosed)
+	__m128 in = _mm_and_ps(
+		_mm_and_ps( _mm_cmple_ps( lo_x, zero ), _mm_cmple_ps( lo_y, zero ) ),
+		_mm_and_ps( _mm_cmplt_ps( zero, hi_x ), _mm_cmplt_ps( zero, hi_y ) ) );
+	return _mm_movemask_ps( in );
+#else
+	AABB other( Vec2( min_x[ base ], min_y[ base ] ), Vec2( max_x[ base ], max_y[ base ] ) );
+	return box.intersects( other ) ? 1u : 0u;
+#endif
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SPATIAL_ARRAY_VIEW_H
+#define SPATIAL_ARRAY_VIEW_H
+
+/*
+================================
+ArrayView
+
+A read-only view of n elements stored elsewhere
+(in a std::vector, a SmallVector or a plain array).
+
+Doesn't own anything: the elements must outlive the view.
+================================
+*/
+template < typename T >
+class ArrayView
+{
+public:
+	ArrayView() : ts( 0 ), n( 0 ) {}
+	ArrayView( const T* ts, int n ) : ts( ts ), n( n ) {}
+
+	int size() const { return n; }
+	bool empty() const { return n == 0; }
+
+	const T* data() const { return ts; }
+	const T& operator [] ( int i ) const { return ts[i]; }
+
+	const T* begin() const { return ts; }
+	const T* end() const { return ts + n; }
+
+private: // Members
+	const T* ts;
+	int n;
+};
+
+#endif
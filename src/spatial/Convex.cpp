@@ -2,6 +2,7 @@
 #include "AABB.h" // for Convex::getAABB
 #include "Wall.h" // for Convex::nearest
 #include "Segment.h"
+#include "SIMD.h" // for Convex::refresh
 
 /*
 ================================
@@ -9,7 +10,7 @@ Convex::Convex
 ================================
 */
 Convex::Convex( const std::vector < Vec2 >& points ) :
-	points( points )
+	points( points.begin(), points.end() )
 {
 	// Compute normals
 	int n = points.size();
@@ -24,6 +25,8 @@ Convex::Convex( const std::vector < Vec2 >& points ) :
 
 	// TODO: we shouldn't have to do this
 	verify();
+
+	refresh();
 }
 
 /*
@@ -46,18 +49,104 @@ const Convex Convex::negation() const
 		ret.normals[i] = -ret.normals[i];
 	}
 
+	ret.refresh();
 	return ret;
 }
 
 /*
 ================================
-Convex::contains (overloaded)
+Convex::contains
+================================
+*/
+bool Convex::contains( const Vec2& p ) const
+{
+	return ConvexView( *this ).contains( p );
+}
+
+/*
+================================
+Convex::nearest
+================================
+*/
+Vec2 Convex::nearest( const Vec2& p ) const
+{
+	return ConvexView( *this ).nearest( p );
+}
+
+/*
+================================
+Convex::getAABB
+================================
+*/
+AABB Convex::getAABB() const
+{
+	return ConvexView( *this ).getAABB();
+}
+
+/*
+================================
+Convex::correction (overloaded)
+================================
+*/
+std::pair < bool, std::pair < Vec2, Scalar > >
+Convex::correction( const Vec2& p ) const
+{
+	return ConvexView( *this ).correction( p );
+}
+
+/*
+================================
+Convex::correction (overloaded)
+================================
+*/
+std::pair < bool, std::pair < Vec2, Scalar > >
+Convex::correction( const Vec2& p, const Vec2& bias ) const
+{
+	return ConvexView( *this ).correction( p, bias );
+}
+
+/*
+================================
+ConvexView::ConvexView (overloaded)
+================================
+*/
+ConvexView::ConvexView( const Convex& c ) :
+	points( c.points.data(), c.points.size() ),
+	normals( c.normals.data(), c.normals.size() ),
+	xs( c.xs.data(), c.xs.size() ),
+	ys( c.ys.data(), c.ys.size() )
+{
+
+}
+
+/*
+================================
+ConvexView::ConvexView (overloaded)
+
+n	the number of points (and normals)
+padded	the length of the structure of arrays
+================================
+*/
+ConvexView::ConvexView(
+	const Vec2* points, const Vec2* normals, int n,
+	const Scalar* xs, const Scalar* ys, int padded ) :
+	points( points, n ),
+	normals( normals, n ),
+	xs( xs, padded ),
+	ys( ys, padded )
+{
+
+}
+
+/*
+================================
+ConvexView::contains
 
 Returns true if this polygon contains the specified point
 (point-in-polygon query).
 ================================
 */
-bool Convex::contains( const Vec2& p ) const
+bool ConvexView::contains( const Vec2& p ) const
 {
 	// A convex polygon can be described
 	// as an intersection of half-spaces.
@@ -71,12 +160,12 @@ bool Convex::contains( const Vec2& p ) const
 
 /*
 ================================
-Convex::nearest
+ConvexView::nearest
 
 Returns the point on this polygon nearest to the specified point.
 ================================
 */
-Vec2 Convex::nearest( const Vec2& p ) const
+Vec2 ConvexView::nearest( const Vec2& p ) const
 {
 	Vec2 ret;
 	Scalar score = SCALAR_MAX;
@@ -100,12 +189,12 @@ Vec2 Convex::nearest( const Vec2& p ) const
 
 /*
 ================================
-Convex::getAABB
+ConvexView::getAABB
 
 Computes the AABB of this polygon.
 ================================
 */
-AABB Convex::getAABB() const
+AABB ConvexView::getAABB() const
 {
 	AABB ret( points[0] );
 
@@ -119,7 +208,7 @@ AABB Convex::getAABB() const
 
 /*
 ================================
-Convex::correction (overloaded)
+ConvexView::correction (overloaded)
 
 Returns:
 	bool	true if this polygon contains the specified point
@@ -131,7 +220,7 @@ the minimum correction to move the specified point out of this polygon.
 ================================
 */
 std::pair < bool, std::pair < Vec2, Scalar > >
-Convex::correction( const Vec2& p ) const
+ConvexView::correction( const Vec2& p ) const
 {
 	std::pair < bool, std::pair < Vec2, Scalar > > ret;
 	Scalar overlap = SCALAR_MAX;
@@ -168,7 +257,7 @@ Convex::correction( const Vec2& p ) const
 
 /*
 ================================
-Convex::correction (overloaded)
+ConvexView::correction (overloaded)
 
 Returns:
 	bool	true if this polygon contains the specified point
@@ -180,7 +269,7 @@ the biased minimum correction to move the specified point out of this polygon.
 ================================
 */
 std::pair < bool, std::pair < Vec2, Scalar > >
-Convex::correction( const Vec2& p, const Vec2& bias ) const
+ConvexView::correction( const Vec2& p, const Vec2& bias ) const
 {
 	std::pair < bool, std::pair < Vec2, Scalar > > ret;
 	Scalar overlap = SCALAR_MAX;
@@ -213,7 +302,7 @@ Convex::correction( const Vec2& p, const Vec2& bias ) const
 
 /*
 ================================
-Convex::sat
+Convex::sat (overloaded)
 
 Separating Axis Theorem algorithm.
 
@@ -223,15 +312,51 @@ Returns:
 ================================
 */
 std::pair < bool, Vec2 >
-Convex::sat( const Convex& a, const Convex& b )
+Convex::sat( const ConvexView& a, const ConvexView& b )
+{
+	int axis = -1;
+	return sat( a, b, axis );
+}
+
+/*
+================================
+Convex::sat (overloaded)
+
+Separating Axis Theorem algorithm, with a hint.
+
+The axis is an index into a's normals followed by b's normals.
+If the hint is valid, that axis is tested first,
+so polygons that are still separated by it cost one projection.
+On return, the axis is the separating axis that was found,
+or the axis of minimum overlap.
+
+Returns the same result as without a hint.
+================================
+*/
+std::pair < bool, Vec2 >
+Convex::sat( const ConvexView& a, const ConvexView& b, int& axis )
 {
 	std::pair < bool, Vec2 > ret;
+	ret.first = false;
+
+	int n_a = a.points.size();
+	int n_b = b.points.size();
+
+	// Hinted axis
+	if ( 0 <= axis && axis < n_a ) {
+		Wall ref( a.points[ axis ], a.normals[ axis ] );
+		if ( 0 < ref.distance( b ) ) return ret;
+	}
+	else if ( n_a <= axis && axis < n_a + n_b ) {
+		Wall ref( b.points[ axis - n_a ], b.normals[ axis - n_a ] );
+		if ( 0 < ref.distance( a ) ) return ret;
+	}
 
 	Scalar overlap = SCALAR_MAX;
 	Vec2 correction;
+	int min_axis = -1;
 
 	// First polygon reference
-	int n_a = a.points.size();
 	for ( int i = 0; i < n_a; ++i ) {
 		// Minimum against reference wall
 		Wall ref( a.points[i], a.normals[i] );
@@ -239,7 +364,7 @@ Convex::sat( const Convex& a, const Convex& b )
 
 		// Early exit
 		if ( 0 < min_b ) {
-			ret.first = false;
+			axis = i;
 			return ret;
 		}
 
@@ -247,17 +372,17 @@ Convex::sat( const Convex& a, const Convex& b )
 		if ( -min_b < overlap ) {
 			overlap = -min_b;
 			correction = ref.normal * overlap;
+			min_axis = i;
 		}
 	}
 
 	// Second polygon reference
-	int n_b = b.points.size();
 	for ( int i = 0; i < n_b; ++i ) {
 		Wall ref( b.points[i], b.normals[i] );
 		Scalar min_a = ref.distance( a );
 
 		if ( 0 < min_a ) {
-			ret.first = false;
+			axis = n_a + i;
 			return ret;
 		}
 
@@ -265,9 +390,11 @@ Convex::sat( const Convex& a, const Convex& b )
 			overlap = -min_a;
 			// Always report correction to second polygon
 			correction = ref.normal * (-overlap);
+			min_axis = n_a + i;
 		}
 	}
 
+	axis = min_axis;
 	ret.first = true;
 	ret.second = correction;
 	return ret;
@@ -360,6 +487,7 @@ bool Convex::verify()
 			normal.normalize();
 			normals.push_back( normal );
 		}
+		refresh();
 		return true;
 	}
 
@@ -452,6 +580,8 @@ void Convex::translate( Vec2 p )
 	for ( int i = 0; i < n; ++i ) {
 		points[i] += p;
 	}
+
+	refresh();
 }
 
 /*
@@ -473,15 +603,63 @@ void Convex::rotate( Scalar rad )
 	for ( int i = 0; i < n; ++i ) {
 		normals[i] = normals[i].rotation( cos, sin );
 	}
+
+	refresh();
 }
 
 /*
 ================================
-Convex::transform
+Convex::transform (overloaded)
 ================================
 */
 void Convex::transform( Vec2 p, Scalar t )
 {
-	rotate( t );
-	translate( p );
+	transform( p, std::cos( t ), std::sin( t ) );
+}
+
+/*
+================================
+Convex::transform (overloaded)
+
+Rotates (by the angle with the specified cosine and sine),
+then translates.
+================================
+*/
+void Convex::transform( Vec2 p, Scalar cos, Scalar sin )
+{
+	int n = points.size();
+
+	for ( int i = 0; i < n; ++i ) {
+		points[i] = points[i].rotation( cos, sin ) + p;
+	}
+
+	for ( int i = 0; i < n; ++i ) {
+		normals[i] = normals[i].rotation( cos, sin );
+	}
+
+	refresh();
+}
+
+/*
+================================
+Convex::refresh
+
+Copies the points into the structure of arrays.
+Must be called whenever the points change
+(all Convex functions that move points do).
+================================
+*/
+void Convex::refresh()
+{
+	int n = points.size();
+	int padded = ( n + SPATIAL_SIMD_LANES - 1 ) / SPATIAL_SIMD_LANES * SPATIAL_SIMD_LANES;
+
+	xs.resize( padded );
+	ys.resize( padded );
+	for ( int i = 0; i < padded; ++i ) {
+		// Repeating a point doesn't change any minimum
+		const Vec2& p = points[ i < n ? i : 0 ];
+		xs[i] = p.x;
+		ys[i] = p.y;
+	}
 }
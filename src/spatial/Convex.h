@@ -4,8 +4,46 @@
 #include <vector> // for std::vector< Vec2 >
 #include "Vec2.h" // for std::vector< Vec2 >
 #include "Wall.h" // for Convex::sat
+#include "SmallVector.h"
+#include "ArrayView.h"
 
 struct AABB;
+struct Convex;
+
+/*
+================================
+A read-only view of a convex polygon stored elsewhere
+(in a Convex, or in a range of a flat buffer of shapes).
+
+All read-only polygon queries work on views;
+the Convex versions forward to them.
+
+The structure of arrays is padded (see Convex::refresh).
+================================
+*/
+struct ConvexView
+{
+public: // Members
+	ArrayView < Vec2 > points;
+	ArrayView < Vec2 > normals;
+	ArrayView < Scalar > xs, ys;
+
+public: // Lifecycle
+	ConvexView() {}
+	ConvexView( const Convex& c );
+	ConvexView(
+		const Vec2* points, const Vec2* normals, int n,
+		const Scalar* xs, const Scalar* ys, int padded );
+
+public: // Convex
+	bool contains( const Vec2& p ) const;
+	Vec2 nearest( const Vec2& p ) const;
+	AABB getAABB() const;
+
+public: // Other
+	std::pair < bool, std::pair < Vec2, Scalar > > correction( const Vec2& p ) const;
+	std::pair < bool, std::pair < Vec2, Scalar > > correction( const Vec2& p, const Vec2& bias ) const;
+};
 
 /*
 ================================
@@ -18,13 +56,19 @@ Non-convex shapes are errors
 (since separating-axis collision won't work on them).
 
 Points are specified counter-clockwise.
+
+Up to INLINE_POINTS points are stored inline (no heap allocations),
+so polygons that small are cheap to copy.
 ================================
 */
 struct Convex
 {
+public: // Constants
+	static const int INLINE_POINTS = 8;
+
 public: // Members
-	std::vector < Vec2 > points;
-	std::vector < Vec2 > normals;
+	SmallVector < Vec2, INLINE_POINTS > points;
+	SmallVector < Vec2, INLINE_POINTS > normals;
 
 public: // Lifecycle
 	Convex( const std::vector < Vec2 >& points );
@@ -39,7 +83,8 @@ public: // Other
 	std::pair < bool, std::pair < Vec2, Scalar > > correction( const Vec2& p ) const;
 	std::pair < bool, std::pair < Vec2, Scalar > > correction( const Vec2& p, const Vec2& bias ) const;
 
-	static std::pair < bool, Vec2 > sat( const Convex& a, const Convex& b );
+	static std::pair < bool, Vec2 > sat( const ConvexView& a, const ConvexView& b );
+	static std::pair < bool, Vec2 > sat( const ConvexView& a, const ConvexView& b, int& axis );
 
 public: // Self
 	bool verify();
@@ -49,6 +94,15 @@ public: // Movement
 	void translate( Vec2 p );
 	void rotate( Scalar rad );
 	void transform( Vec2 p, Scalar t );
+	void transform( Vec2 p, Scalar cos, Scalar sin );
+
+public: // Structure of arrays
+	// Copy of the points as separate x and y arrays, for SIMD projections
+	// (see Wall::distance). Padded to a multiple of SPATIAL_SIMD_LANES
+	// by repeating the first point.
+	SmallVector < Scalar, INLINE_POINTS > xs, ys;
+
+	void refresh();
 };
 
 #endif
@@ -17,14 +17,31 @@ class PD_BruteForce
 public:
 	~PD_BruteForce() {}
 
+	void clear();
 	void insert( Vec2, T );
 	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
 
 private: // Members
 	typedef std::pair < Vec2, T > Entry;
 	std::vector < Entry > entries;
 };
 
+/*
+================================
+PD_BruteForce::clear
+
+Removes all entries, but keeps all storage.
+================================
+*/
+template < typename T >
+void PD_BruteForce < T >::clear()
+{
+	entries.clear();
+}
+
 /*
 ================================
 PD_BruteForce::insert
@@ -38,21 +55,50 @@ void PD_BruteForce < T >::insert( Vec2 v, T t )
 
 /*
 ================================
-PD_BruteForce::query
+PD_BruteForce::query (overloaded)
+
+Returns the results in a new vector.
 ================================
 */
 template < typename T >
 std::vector < T > PD_BruteForce < T >::query( const AABB& box ) const
 {
 	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
+
+/*
+================================
+PD_BruteForce::query (overloaded)
 
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void PD_BruteForce < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+PD_BruteForce::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void PD_BruteForce < T >::query( const AABB& box, F&& visit ) const
+{
 	for ( const Entry& e : entries ) {
 		if ( box.contains( e.first ) ) {
-			ts.push_back( e.second );
+			visit( e.second );
 		}
 	}
-
-	return ts;
 }
 
 #endif
@@ -0,0 +1,232 @@
+#ifndef POINT_DATA_HASH_GRID_H
+#define POINT_DATA_HASH_GRID_H
+
+#include <vector>
+#include <cmath> // for std::floor
+#include "AABB.h" // for query
+
+/*
+================================
+PD_HashGrid
+
+Spatial hash grid implementation of PointData.
+
+Points are binned into square cells of a fixed size,
+and cells are hashed into buckets (chained through the entry list).
+A query only visits the cells its box overlaps.
+
+Meant to be cleared and refilled every frame:
+clear keeps all storage, so a steady-state frame doesn't allocate.
+================================
+*/
+template < typename T >
+class PD_HashGrid
+{
+public:
+	PD_HashGrid( Scalar cell = 64.0 );
+	~PD_HashGrid() {}
+
+	void clear();
+	void insert( Vec2, T );
+	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
+
+private: // Functions
+	int cell_of( Scalar x ) const;
+	unsigned int bucket_of( int ix, int iy ) const;
+	void rehash();
+
+private: // Members
+	struct Entry
+	{
+		Vec2 v;
+		T t;
+		int ix, iy; // cell coordinates
+		int next; // next entry in the same bucket
+	};
+
+	std::vector < Entry > entries;
+	std::vector < int > heads; // first entry of each bucket
+
+	Scalar cell;
+};
+
+/*
+================================
+PD_HashGrid::PD_HashGrid
+================================
+*/
+template < typename T >
+PD_HashGrid < T >::PD_HashGrid( Scalar cell ) :
+	heads( 64, -1 ),
+	cell( cell )
+{
+
+}
+
+/*
+================================
+PD_HashGrid::clear
+
+Removes all entries, but keeps all storage.
+================================
+*/
+template < typename T >
+void PD_HashGrid < T >::clear()
+{
+	entries.clear();
+	std::fill( heads.begin(), heads.end(), -1 );
+}
+
+/*
+================================
+PD_HashGrid::insert
+================================
+*/
+template < typename T >
+void PD_HashGrid < T >::insert( Vec2 v, T t )
+{
+	// Keep the load factor at most one
+	if ( entries.size() >= heads.size() ) rehash();
+
+	Entry e;
+	e.v = v;
+	e.t = t;
+	e.ix = cell_of( v.x );
+	e.iy = cell_of( v.y );
+
+	unsigned int b = bucket_of( e.ix, e.iy );
+	e.next = heads[ b ];
+	heads[ b ] = entries.size();
+	entries.push_back( e );
+}
+
+/*
+================================
+PD_HashGrid::query (overloaded)
+
+Returns the results in a new vector.
+================================
+*/
+template < typename T >
+std::vector < T > PD_HashGrid < T >::query( const AABB& box ) const
+{
+	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
+
+/*
+================================
+PD_HashGrid::query (overloaded)
+
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void PD_HashGrid < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+PD_HashGrid::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void PD_HashGrid < T >::query( const AABB& box, F&& visit ) const
+{
+	int ix0 = cell_of( box.min.x ), ix1 = cell_of( box.max.x );
+	int iy0 = cell_of( box.min.y ), iy1 = cell_of( box.max.y );
+
+	// Huge boxes: scanning every entry is cheaper than visiting every cell
+	double cells = ( double( ix1 ) - ix0 + 1 ) * ( double( iy1 ) - iy0 + 1 );
+	if ( cells > entries.size() ) {
+		for ( const Entry& e : entries ) {
+			if ( box.contains( e.v ) ) {
+				visit( e.t );
+			}
+		}
+		return;
+	}
+
+	for ( int iy = iy0; iy <= iy1; ++iy ) {
+	for ( int ix = ix0; ix <= ix1; ++ix ) {
+		int i = heads[ bucket_of( ix, iy ) ];
+		for ( ; i >= 0; i = entries[i].next ) {
+			const Entry& e = entries[i];
+			// Other cells may hash into the same bucket
+			if ( e.ix != ix || e.iy != iy ) continue;
+			if ( box.contains( e.v ) ) {
+				visit( e.t );
+			}
+		}
+	}}
+}
+
+/*
+================================
+PD_HashGrid::cell_of
+
+Clamped to +/- 2^30 before the cast (which is undefined out of range),
+so huge, infinite and NaN coordinates (a runaway Verlet, an unbounded
+query box) land in the outermost cells. Query ranges then count
+far more cells than entries, and take the full scan.
+================================
+*/
+template < typename T >
+int PD_HashGrid < T >::cell_of( Scalar x ) const
+{
+	const int limit = 1 << 30;
+	Scalar c = std::floor( x / cell );
+	if ( !( c > -limit ) ) return -limit; // (and NaN)
+	if ( c > limit ) return limit;
+	return (int) c;
+}
+
+/*
+================================
+PD_HashGrid::bucket_of
+
+The bucket count is always a power of two.
+================================
+*/
+template < typename T >
+unsigned int PD_HashGrid < T >::bucket_of( int ix, int iy ) const
+{
+	unsigned int h =
+		( (unsigned int) ix * 73856093u ) ^
+		( (unsigned int) iy * 19349663u );
+	return h & ( heads.size() - 1 );
+}
+
+/*
+================================
+PD_HashGrid::rehash
+
+Doubles the bucket count and re-links all entries.
+================================
+*/
+template < typename T >
+void PD_HashGrid < T >::rehash()
+{
+	heads.assign( heads.size() * 2, -1 );
+
+	int n = entries.size();
+	for ( int i = 0; i < n; ++i ) {
+		Entry& e = entries[i];
+		unsigned int b = bucket_of( e.ix, e.iy );
+		e.next = heads[ b ];
+		heads[ b ] = i;
+	}
+}
+
+#endif
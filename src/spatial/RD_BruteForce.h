@@ -2,13 +2,16 @@
 #define REGION_DATA_BRUTE_FORCE_H
 
 #include <vector>
-#include "AABB.h" // for query
+#include "AABBArray.h" // for query
 
 /*
 ================================
 RD_BruteForce
 
 Brute force implementation of RegionData.
+
+Boxes are kept in an AABBArray, so queries test
+several boxes per instruction.
 ================================
 */
 template < typename T >
@@ -17,14 +20,35 @@ class RD_BruteForce
 public:
 	~RD_BruteForce() {}
 
+	void clear();
 	void insert( AABB, T );
 	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
+
+	template < typename F >
+	void find_all_pairs( F&& visit ) const;
 
 private: // Members
-	typedef std::pair < AABB, T > Entry;
-	std::vector < Entry > entries;
+	AABBArray boxes;
+	std::vector < T > ts;
 };
 
+/*
+================================
+RD_BruteForce::clear
+
+Removes all entries, but keeps all storage.
+================================
+*/
+template < typename T >
+void RD_BruteForce < T >::clear()
+{
+	boxes.clear();
+	ts.clear();
+}
+
 /*
 ================================
 RD_BruteForce::insert
@@ -33,26 +57,68 @@ RD_BruteForce::insert
 template < typename T >
 void RD_BruteForce < T >::insert( AABB box, T t )
 {
-	entries.push_back( Entry( box, t ) );
+	boxes.push_back( box );
+	ts.push_back( t );
 }
 
 /*
 ================================
-RD_BruteForce::query
+RD_BruteForce::query (overloaded)
+
+Returns the results in a new vector.
 ================================
 */
 template < typename T >
 std::vector < T > RD_BruteForce < T >::query( const AABB& box ) const
 {
 	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
 
-	for ( const Entry& e : entries ) {
-		if ( box.intersects( e.first ) ) {
-			ts.push_back( e.second );
-		}
-	}
+/*
+================================
+RD_BruteForce::query (overloaded)
 
-	return ts;
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void RD_BruteForce < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+RD_BruteForce::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_BruteForce < T >::query( const AABB& box, F&& visit ) const
+{
+	boxes.query( box, [this, &visit]( int i ) { visit( ts[i] ); } );
+}
+
+/*
+================================
+RD_BruteForce::find_all_pairs
+
+Calls visit( t, u ) for each pair of entries with intersecting boxes,
+where u was inserted before t
+(the same pairs as querying each entry before inserting it).
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_BruteForce < T >::find_all_pairs( F&& visit ) const
+{
+	boxes.find_all_pairs( [this, &visit]( int i, int j ) { visit( ts[i], ts[j] ); } );
 }
 
 #endif
@@ -0,0 +1,583 @@
+#ifndef REGION_DATA_DYNAMIC_TREE_H
+#define REGION_DATA_DYNAMIC_TREE_H
+
+#include <vector>
+#include <cassert>
+#include "AABB.h" // for query
+#include "Ray.h" // for raycast
+
+/*
+================================
+RD_DynamicTree
+
+Dynamic AABB tree implementation of RegionData.
+
+A balanced binary tree of bounding boxes that persists across frames.
+Leaves store "fat" boxes (the inserted box plus a margin),
+so a proxy that moves a little doesn't need to touch the tree at all;
+it is only re-inserted when its box leaves its fat box.
+
+insert returns a proxy ID, which is used to move or remove the entry.
+
+PDF: Dynamic Bounding Volume Hierarchies (Catto 2019)
+================================
+*/
+template < typename T >
+class RD_DynamicTree
+{
+public:
+	RD_DynamicTree( Scalar margin = 8.0 );
+	~RD_DynamicTree() {}
+
+	int insert( AABB, T );
+	bool move( int proxy, const AABB& box );
+	void remove( int proxy );
+
+	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
+	template < typename F >
+	void raycast( const Ray&, Scalar t_max, F&& visit ) const;
+
+	T& operator [] ( int proxy );
+	const AABB& fat( int proxy ) const;
+
+	int height() const;
+
+private: // Functions
+	int allocate();
+	void release( int id );
+
+	void insert_leaf( int leaf );
+	void remove_leaf( int leaf );
+	int balance( int id );
+	void refit( int id );
+
+	static Scalar perimeter( const AABB& box );
+
+private: // Members
+	struct Node
+	{
+		AABB box; // fat box (leaves) or union of children (branches)
+		T t;
+
+		int parent; // also the free list link
+		int child1, child2; // -1 for leaves
+		int height; // 0 for leaves, -1 for free nodes
+
+		bool leaf() const { return child1 < 0; }
+	};
+
+	std::vector < Node > nodes;
+	int root;
+	int free_list;
+
+	Scalar margin;
+};
+
+/*
+================================
+RD_DynamicTree::RD_DynamicTree
+================================
+*/
+template < typename T >
+RD_DynamicTree < T >::RD_DynamicTree( Scalar margin ) :
+	root( -1 ),
+	free_list( -1 ),
+	margin( margin )
+{
+
+}
+
+/*
+================================
+RD_DynamicTree::insert
+
+Returns a proxy ID for the new entry.
+================================
+*/
+template < typename T >
+int RD_DynamicTree < T >::insert( AABB box, T t )
+{
+	int leaf = allocate();
+	Node& n = nodes[ leaf ];
+	n.box = box.fatter( margin );
+	n.t = t;
+	n.height = 0;
+
+	insert_leaf( leaf );
+	return leaf;
+}
+
+/*
+================================
+RD_DynamicTree::move
+
+Updates the box of the specified proxy.
+
+Returns true if the proxy was re-inserted
+(the new box escaped the old fat box).
+================================
+*/
+template < typename T >
+bool RD_DynamicTree < T >::move( int proxy, const AABB& box )
+{
+	assert( nodes[ proxy ].leaf() );
+
+	if ( nodes[ proxy ].box.contains( box ) ) return false;
+
+	remove_leaf( proxy );
+	nodes[ proxy ].box = box.fatter( margin );
+	insert_leaf( proxy );
+	return true;
+}
+
+/*
+================================
+RD_DynamicTree::remove
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::remove( int proxy )
+{
+	assert( nodes[ proxy ].leaf() );
+
+	remove_leaf( proxy );
+	release( proxy );
+}
+
+/*
+================================
+RD_DynamicTree::query (overloaded)
+
+Returns the results in a new vector.
+================================
+*/
+template < typename T >
+std::vector < T > RD_DynamicTree < T >::query( const AABB& box ) const
+{
+	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
+
+/*
+================================
+RD_DynamicTree::query (overloaded)
+
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+RD_DynamicTree::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_DynamicTree < T >::query( const AABB& box, F&& visit ) const
+{
+	if ( root < 0 ) return;
+
+	int stack[ 64 ];
+	int top = 0;
+	stack[ top++ ] = root;
+
+	while ( top > 0 ) {
+		const Node& n = nodes[ stack[ --top ] ];
+		if ( ! box.intersects( n.box ) ) continue;
+
+		if ( n.leaf() ) {
+			visit( n.t );
+		}
+		else {
+			// A balanced tree never gets this deep
+			assert( top + 2 <= 64 );
+			stack[ top++ ] = n.child1;
+			stack[ top++ ] = n.child2;
+		}
+	}
+}
+
+/*
+================================
+RD_DynamicTree::raycast
+
+Calls visit( t ) for each proxy whose fat box is hit
+by the part of the specified ray with t in [ 0, t_max ].
+
+visit returns the new t_max, so a search for the first hit
+can clip the ray as it finds closer hits
+(returning the old t_max keeps going).
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_DynamicTree < T >::raycast( const Ray& ray, Scalar t_max, F&& visit ) const
+{
+	if ( root < 0 ) return;
+
+	int stack[ 64 ];
+	int top = 0;
+	stack[ top++ ] = root;
+
+	while ( top > 0 ) {
+		const Node& n = nodes[ stack[ --top ] ];
+		if ( ! ray.intersects( n.box, t_max ) ) continue;
+
+		if ( n.leaf() ) {
+			t_max = visit( n.t );
+		}
+		else {
+			assert( top + 2 <= 64 );
+			stack[ top++ ] = n.child1;
+			stack[ top++ ] = n.child2;
+		}
+	}
+}
+
+/*
+================================
+RD_DynamicTree::operator []
+
+Returns the data stored with the specified proxy.
+================================
+*/
+template < typename T >
+T& RD_DynamicTree < T >::operator [] ( int proxy )
+{
+	return nodes[ proxy ].t;
+}
+
+/*
+================================
+RD_DynamicTree::fat
+
+Returns the fat box of the specified proxy.
+================================
+*/
+template < typename T >
+const AABB& RD_DynamicTree < T >::fat( int proxy ) const
+{
+	return nodes[ proxy ].box;
+}
+
+/*
+================================
+RD_DynamicTree::height
+================================
+*/
+template < typename T >
+int RD_DynamicTree < T >::height() const
+{
+	return root < 0 ? 0 : nodes[ root ].height;
+}
+
+/*
+================================
+RD_DynamicTree::allocate
+
+Returns a node from the free list (or a new node).
+================================
+*/
+template < typename T >
+int RD_DynamicTree < T >::allocate()
+{
+	int id;
+	if ( free_list < 0 ) {
+		id = nodes.size();
+		nodes.push_back( Node() );
+	}
+	else {
+		id = free_list;
+		free_list = nodes[ id ].parent;
+	}
+
+	Node& n = nodes[ id ];
+	n.parent = -1;
+	n.child1 = -1;
+	n.child2 = -1;
+	n.height = 0;
+	return id;
+}
+
+/*
+================================
+RD_DynamicTree::release
+
+Returns a node to the free list.
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::release( int id )
+{
+	nodes[ id ].parent = free_list;
+	nodes[ id ].height = -1;
+	free_list = id;
+}
+
+/*
+================================
+RD_DynamicTree::insert_leaf
+
+Finds the cheapest sibling for the specified leaf
+(surface area heuristic), then pairs them under a new branch.
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::insert_leaf( int leaf )
+{
+	if ( root < 0 ) {
+		root = leaf;
+		nodes[ root ].parent = -1;
+		return;
+	}
+
+	// Find the best sibling
+	AABB box = nodes[ leaf ].box;
+	int sibling = root;
+	while ( ! nodes[ sibling ].leaf() ) {
+		const Node& n = nodes[ sibling ];
+		int c1 = n.child1;
+		int c2 = n.child2;
+
+		Scalar area = perimeter( n.box );
+		Scalar combined = perimeter( n.box + box );
+
+		// Cost of creating a new parent for this node and the new leaf
+		Scalar cost = 2 * combined;
+		// Minimum cost of pushing the leaf further down the tree
+		Scalar inheritance = 2 * ( combined - area );
+
+		// Cost of descending into each child
+		Scalar cost1 = perimeter( box + nodes[ c1 ].box ) + inheritance;
+		if ( ! nodes[ c1 ].leaf() ) cost1 -= perimeter( nodes[ c1 ].box );
+		Scalar cost2 = perimeter( box + nodes[ c2 ].box ) + inheritance;
+		if ( ! nodes[ c2 ].leaf() ) cost2 -= perimeter( nodes[ c2 ].box );
+
+		if ( cost < cost1 && cost < cost2 ) break;
+
+		sibling = ( cost1 < cost2 ) ? c1 : c2;
+	}
+
+	// Create a new parent
+	// (allocate may reallocate nodes, so no references before this)
+	int old_parent = nodes[ sibling ].parent;
+	int new_parent = allocate();
+	nodes[ new_parent ].parent = old_parent;
+	nodes[ new_parent ].box = box + nodes[ sibling ].box;
+	nodes[ new_parent ].height = nodes[ sibling ].height + 1;
+	nodes[ new_parent ].child1 = sibling;
+	nodes[ new_parent ].child2 = leaf;
+	nodes[ sibling ].parent = new_parent;
+	nodes[ leaf ].parent = new_parent;
+
+	if ( old_parent < 0 ) {
+		root = new_parent;
+	}
+	else if ( nodes[ old_parent ].child1 == sibling ) {
+		nodes[ old_parent ].child1 = new_parent;
+	}
+	else {
+		nodes[ old_parent ].child2 = new_parent;
+	}
+
+	// Walk back up the tree fixing heights and boxes
+	refit( nodes[ leaf ].parent );
+}
+
+/*
+================================
+RD_DynamicTree::remove_leaf
+
+Detaches the specified leaf, replacing its parent with its sibling.
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::remove_leaf( int leaf )
+{
+	if ( leaf == root ) {
+		root = -1;
+		return;
+	}
+
+	int parent = nodes[ leaf ].parent;
+	int grand_parent = nodes[ parent ].parent;
+	int sibling = ( nodes[ parent ].child1 == leaf ) ?
+		nodes[ parent ].child2 :
+		nodes[ parent ].child1;
+
+	release( parent );
+
+	if ( grand_parent < 0 ) {
+		root = sibling;
+		nodes[ sibling ].parent = -1;
+		return;
+	}
+
+	if ( nodes[ grand_parent ].child1 == parent ) {
+		nodes[ grand_parent ].child1 = sibling;
+	}
+	else {
+		nodes[ grand_parent ].child2 = sibling;
+	}
+	nodes[ sibling ].parent = grand_parent;
+
+	refit( grand_parent );
+}
+
+/*
+================================
+RD_DynamicTree::refit
+
+Rebalances and recomputes boxes and heights
+from the specified node up to the root.
+================================
+*/
+template < typename T >
+void RD_DynamicTree < T >::refit( int id )
+{
+	while ( id >= 0 ) {
+		id = balance( id );
+
+		Node& n = nodes[ id ];
+		const Node& c1 = nodes[ n.child1 ];
+		const Node& c2 = nodes[ n.child2 ];
+		n.height = 1 + std::max( c1.height, c2.height );
+		n.box = c1.box + c2.box;
+
+		id = n.parent;
+	}
+}
+
+/*
+================================
+RD_DynamicTree::balance
+
+Performs a left or right rotation if the specified node is imbalanced.
+Returns the ID of the node that replaced it (or the same ID).
+================================
+*/
+template < typename T >
+int RD_DynamicTree < T >::balance( int ia )
+{
+	Node& a = nodes[ ia ];
+	if ( a.leaf() || a.height < 2 ) return ia;
+
+	int ib = a.child1;
+	int ic = a.child2;
+	Node& b = nodes[ ib ];
+	Node& c = nodes[ ic ];
+
+	int diff = c.height - b.height;
+
+	// Rotate C up
+	if ( diff > 1 ) {
+		int f = c.child1;
+		int g = c.child2;
+
+		// Swap A and C
+		c.child1 = ia;
+		c.parent = a.parent;
+		a.parent = ic;
+
+		// A's old parent should point to C
+		if ( c.parent < 0 ) {
+			root = ic;
+		}
+		else if ( nodes[ c.parent ].child1 == ia ) {
+			nodes[ c.parent ].child1 = ic;
+		}
+		else {
+			nodes[ c.parent ].child2 = ic;
+		}
+
+		// Keep the taller grandchild under C
+		if ( nodes[ f ].height > nodes[ g ].height ) {
+			c.child2 = f;
+			a.child2 = g;
+			nodes[ g ].parent = ia;
+		}
+		else {
+			c.child2 = g;
+			a.child2 = f;
+			nodes[ f ].parent = ia;
+		}
+
+		a.box = b.box + nodes[ a.child2 ].box;
+		a.height = 1 + std::max( b.height, nodes[ a.child2 ].height );
+		c.box = a.box + nodes[ c.child2 ].box;
+		c.height = 1 + std::max( a.height, nodes[ c.child2 ].height );
+
+		return ic;
+	}
+
+	// Rotate B up
+	if ( diff < -1 ) {
+		int d = b.child1;
+		int e = b.child2;
+
+		// Swap A and B
+		b.child1 = ia;
+		b.parent = a.parent;
+		a.parent = ib;
+
+		// A's old parent should point to B
+		if ( b.parent < 0 ) {
+			root = ib;
+		}
+		else if ( nodes[ b.parent ].child1 == ia ) {
+			nodes[ b.parent ].child1 = ib;
+		}
+		else {
+			nodes[ b.parent ].child2 = ib;
+		}
+
+		// Keep the taller grandchild under B
+		if ( nodes[ d ].height > nodes[ e ].height ) {
+			b.child2 = d;
+			a.child1 = e;
+			nodes[ e ].parent = ia;
+		}
+		else {
+			b.child2 = e;
+			a.child1 = d;
+			nodes[ d ].parent = ia;
+		}
+
+		a.box = c.box + nodes[ a.child1 ].box;
+		a.height = 1 + std::max( c.height, nodes[ a.child1 ].height );
+		b.box = a.box + nodes[ b.child2 ].box;
+		b.height = 1 + std::max( a.height, nodes[ b.child2 ].height );
+
+		return ib;
+	}
+
+	return ia;
+}
+
+/*
+================================
+RD_DynamicTree::perimeter
+
+Half the perimeter is enough for comparing costs.
+================================
+*/
+template < typename T >
+Scalar RD_DynamicTree < T >::perimeter( const AABB& box )
+{
+	return box.width() + box.height();
+}
+
+#endif
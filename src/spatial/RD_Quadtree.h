@@ -0,0 +1,248 @@
+#ifndef REGION_DATA_QUADTREE_H
+#define REGION_DATA_QUADTREE_H
+
+#include <vector>
+#include <cassert>
+#include "AABB.h" // for query
+
+/*
+================================
+RD_Quadtree
+
+Loose quadtree implementation of RegionData.
+
+Each node covers a cell (a quadrant of its parent's cell, see AABB::subdiv),
+and holds every entry whose center lies in the cell and
+which is too big to fit in a child cell.
+A node's "loose" box is its cell grown by half the cell size on each side,
+so it always encloses the boxes of its entries.
+
+Big entries stay near the root, so they don't
+make queries for small entries touch every small entry.
+
+Entries whose centers are outside the root cell stay in the root.
+
+Meant to be cleared and refilled every frame:
+nodes and entries are pooled, and clear keeps all storage.
+================================
+*/
+template < typename T >
+class RD_Quadtree
+{
+public:
+	RD_Quadtree( const AABB& bounds = AABB(), int max_depth = 8 );
+	~RD_Quadtree() {}
+
+	void clear();
+	void clear( const AABB& bounds );
+
+	void insert( AABB, T );
+	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
+
+	int size() const { return entries.size(); }
+	int nodes_used() const { return nodes.size(); }
+
+private: // Functions
+	int allocate( const AABB& cell );
+
+private: // Members
+	struct Node
+	{
+		AABB cell;
+		AABB loose;
+		int children[4]; // -1 for none, indexed by quadrant
+		int first; // first entry in this node
+	};
+
+	struct Entry
+	{
+		AABB box;
+		T t;
+		int next; // next entry in the same node
+	};
+
+	std::vector < Node > nodes; // nodes[0] is the root
+	std::vector < Entry > entries;
+
+	AABB bounds;
+	int max_depth;
+};
+
+/*
+================================
+RD_Quadtree::RD_Quadtree
+================================
+*/
+template < typename T >
+RD_Quadtree < T >::RD_Quadtree( const AABB& bounds, int max_depth ) :
+	bounds( bounds ),
+	max_depth( max_depth )
+{
+	// See the query stack
+	assert( max_depth <= 32 );
+
+	clear();
+}
+
+/*
+================================
+RD_Quadtree::clear (overloaded)
+
+Removes all entries, but keeps all storage.
+================================
+*/
+template < typename T >
+void RD_Quadtree < T >::clear()
+{
+	nodes.clear();
+	entries.clear();
+	allocate( bounds );
+}
+
+/*
+================================
+RD_Quadtree::clear (overloaded)
+
+Removes all entries and resizes the root cell.
+================================
+*/
+template < typename T >
+void RD_Quadtree < T >::clear( const AABB& bounds )
+{
+	this->bounds = bounds;
+	clear();
+}
+
+/*
+================================
+RD_Quadtree::insert
+================================
+*/
+template < typename T >
+void RD_Quadtree < T >::insert( AABB box, T t )
+{
+	Vec2 center = box.center();
+
+	int id = 0;
+	if ( nodes[0].cell.contains( center ) ) {
+		for ( int depth = 0; depth < max_depth; ++depth ) {
+			const AABB& cell = nodes[ id ].cell;
+
+			// Entries fit in a child if they're no bigger than its cell
+			// (the loose box has room for the rest)
+			if ( box.width() > cell.width() * 0.5 ) break;
+			if ( box.height() > cell.height() * 0.5 ) break;
+
+			unsigned int quad = cell.center().quadrant( center );
+			int child = nodes[ id ].children[ quad ];
+			if ( child < 0 ) {
+				// allocate may reallocate nodes; no references across this
+				child = allocate( nodes[ id ].cell.subdiv( quad ) );
+				nodes[ id ].children[ quad ] = child;
+			}
+			id = child;
+		}
+	}
+
+	Entry e;
+	e.box = box;
+	e.t = t;
+	e.next = nodes[ id ].first;
+	nodes[ id ].first = entries.size();
+	entries.push_back( e );
+}
+
+/*
+================================
+RD_Quadtree::query (overloaded)
+
+Returns the results in a new vector.
+================================
+*/
+template < typename T >
+std::vector < T > RD_Quadtree < T >::query( const AABB& box ) const
+{
+	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
+
+/*
+================================
+RD_Quadtree::query (overloaded)
+
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void RD_Quadtree < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+RD_Quadtree::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_Quadtree < T >::query( const AABB& box, F&& visit ) const
+{
+	// Depth-first; each level pushes at most four nodes
+	int stack[ 4 * 32 + 1 ];
+	int top = 0;
+	stack[ top++ ] = 0;
+
+	while ( top > 0 ) {
+		int id = stack[ --top ];
+		const Node& n = nodes[ id ];
+
+		// The root also holds entries outside its cell
+		if ( id != 0 && ! box.intersects( n.loose ) ) continue;
+
+		for ( int i = n.first; i >= 0; i = entries[i].next ) {
+			const Entry& e = entries[i];
+			if ( box.intersects( e.box ) ) {
+				visit( e.t );
+			}
+		}
+
+		for ( int quad = 0; quad < 4; ++quad ) {
+			if ( n.children[ quad ] < 0 ) continue;
+			stack[ top++ ] = n.children[ quad ];
+		}
+	}
+}
+
+/*
+================================
+RD_Quadtree::allocate
+
+Returns a new node from the pool.
+================================
+*/
+template < typename T >
+int RD_Quadtree < T >::allocate( const AABB& cell )
+{
+	Node n;
+	n.cell = cell;
+	Vec2 half( cell.width() * 0.5, cell.height() * 0.5 );
+	n.loose = AABB( cell.min - half, cell.max + half );
+	for ( int quad = 0; quad < 4; ++quad ) {
+		n.children[ quad ] = -1;
+	}
+	n.first = -1;
+
+	nodes.push_back( n );
+	return nodes.size() - 1;
+}
+
+#endif
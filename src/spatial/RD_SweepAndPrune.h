@@ -0,0 +1,753 @@
+#ifndef REGION_DATA_SWEEP_AND_PRUNE_H
+#define REGION_DATA_SWEEP_AND_PRUNE_H
+
+#include <vector>
+#include <unordered_set>
+#include <algorithm> // for std::sort, std::inplace_merge, std::nth_element
+#include <cassert>
+#include "AABB.h" // for query
+
+/*
+================================
+RD_SweepAndPrune
+
+Incremental sweep-and-prune implementation of RegionData.
+
+Keeps a sorted list of box endpoints on each axis across frames.
+When a proxy moves, its endpoints are insertion-sorted into place;
+every time a min endpoint crosses a max endpoint,
+the overlap state of that pair may change, and the set of
+overlapping pairs is updated.
+
+When proxies move a little between frames, each update
+only swaps a few endpoints (nearly linear time overall).
+
+Inserts and removes are batched: they are applied together
+on the next move, pairs, events or flush call. New endpoints are sorted
+once and merged in, and one sweep finds the new proxies' pairs,
+so building from scratch takes O(n log n) instead of O(n^2).
+
+Pair events (pairs that started or stopped overlapping)
+are logged until the next events call, which reports the net
+change since the call before; call it every frame.
+
+Queries binary-search the x endpoints: proxies no longer than
+a reach (twice the median length on x) start at most that far
+to the left of the query box. Longer proxies (like a level's
+floor) are checked one by one.
+
+Max endpoints are stored inflated by the same slop as AABB::intersects,
+and a min endpoint sorts before a max endpoint with the same value,
+so two proxies overlap here when their boxes intersect.
+
+NOTE: The only disagreements are exact ties on the slop boundary
+(AABB::intersects is closed on one side only, so it isn't symmetric)
+and rounding there (a.min <= b.max + 1 versus a.min - b.max - 1 <= 0).
+================================
+*/
+template < typename T >
+class RD_SweepAndPrune
+{
+public:
+	RD_SweepAndPrune() : reach( 0 ) {}
+	~RD_SweepAndPrune() {}
+
+	int insert( AABB, T );
+	void move( int proxy, const AABB& box );
+	void remove( int proxy );
+	void flush();
+
+	std::vector < T > query( const AABB& ) const;
+	void query( const AABB&, std::vector < T >& out ) const;
+	template < typename F >
+	void query( const AABB&, F&& visit ) const;
+
+	T& operator [] ( int proxy );
+
+public: // Overlap pairs
+	// Two proxies, ordered ( lo, hi )
+	typedef std::pair < int, int > Pair;
+
+	std::vector < Pair > pairs();
+	void pairs( std::vector < Pair >& out );
+	template < typename F >
+	void pairs( F&& visit );
+	void events( std::vector < Pair >& added, std::vector < Pair >& removed );
+
+private: // Functions
+	void flush_removes();
+	void flush_inserts();
+	void reindex( int axis );
+	void measure();
+
+	void sort_min_down( int axis, int e );
+	void sort_min_up( int axis, int e );
+	void sort_max_down( int axis, int e );
+	void sort_max_up( int axis, int e );
+	void swap( int axis, int e, int f );
+
+	bool overlaps( int axis, int p, int q ) const;
+	static Scalar max_value( const AABB& box, int axis );
+	void add_pair( int p, int q );
+	void remove_pair( int p, int q );
+
+	static unsigned long long pair_key( int p, int q );
+
+private: // Members
+	struct Endpoint
+	{
+		Scalar value;
+		int proxy;
+		bool max;
+
+		// Sort order (ties put min endpoints first)
+		bool operator < ( const Endpoint& e ) const {
+			if ( value != e.value ) return value < e.value;
+			return ! max && e.max;
+		}
+	};
+
+	struct Proxy
+	{
+		AABB box;
+		T t;
+		int min[2], max[2]; // endpoint indices, per axis
+		bool live;
+		bool fresh; // inserted, but not sorted in yet
+		bool big; // longer than reach on x (see query)
+	};
+
+	std::vector < Endpoint > axes[2];
+	std::vector < Proxy > proxies;
+	std::vector < int > free_list;
+
+	// Waiting for flush
+	std::vector < int > inserted;
+	std::vector < int > removed;
+
+	std::unordered_set < unsigned long long > overlapping;
+
+	// Pair events since the last events call ( key, added ), in order
+	std::vector < std::pair < unsigned long long, bool > > event_log;
+
+	// See query
+	Scalar reach;
+	std::vector < int > big_proxies;
+};
+
+/*
+================================
+RD_SweepAndPrune::insert
+
+Returns a proxy ID for the new entry.
+
+The proxy is sorted in (and reports pairs) on the next flush.
+================================
+*/
+template < typename T >
+int RD_SweepAndPrune < T >::insert( AABB box, T t )
+{
+	int id;
+	if ( free_list.empty() ) {
+		id = proxies.size();
+		proxies.push_back( Proxy() );
+	}
+	else {
+		id = free_list.back();
+		free_list.pop_back();
+	}
+
+	Proxy& p = proxies[ id ];
+	p.box = box;
+	p.t = t;
+	p.live = true;
+	p.fresh = true;
+	p.big = false;
+	inserted.push_back( id );
+
+	return id;
+}
+
+/*
+================================
+RD_SweepAndPrune::move
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::move( int proxy, const AABB& box )
+{
+	flush();
+
+	Proxy& p = proxies[ proxy ];
+	assert( p.live );
+
+	for ( int axis = 0; axis < 2; ++axis ) {
+		std::vector < Endpoint >& es = axes[ axis ];
+
+		Scalar& lo = es[ p.min[ axis ] ].value;
+		Scalar& hi = es[ p.max[ axis ] ].value;
+
+		Scalar dmin = box.min[ axis ] - lo;
+		Scalar dmax = max_value( box, axis ) - hi;
+
+		lo = box.min[ axis ];
+		hi = max_value( box, axis );
+
+		// Grow first (adds pairs), then shrink (removes pairs)
+		if ( dmin < 0 ) sort_min_down( axis, p.min[ axis ] );
+		if ( dmax > 0 ) sort_max_up( axis, p.max[ axis ] );
+		if ( dmin > 0 ) sort_min_up( axis, p.min[ axis ] );
+		if ( dmax < 0 ) sort_max_down( axis, p.max[ axis ] );
+	}
+
+	p.box = box;
+
+	if ( ! p.big && max_value( box, 0 ) - box.min[0] > reach ) {
+		p.big = true;
+		big_proxies.push_back( proxy );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::remove
+
+The proxy stops showing up in queries right away;
+its endpoints and pairs are dropped on the next flush.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::remove( int proxy )
+{
+	Proxy& p = proxies[ proxy ];
+	assert( p.live );
+
+	p.live = false;
+	removed.push_back( proxy );
+}
+
+/*
+================================
+RD_SweepAndPrune::flush
+
+Applies all pending removes, then all pending inserts.
+
+move, pairs and events call this themselves.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::flush()
+{
+	if ( removed.empty() && inserted.empty() ) return;
+	if ( ! removed.empty() ) flush_removes();
+	if ( ! inserted.empty() ) flush_inserts();
+	measure();
+}
+
+/*
+================================
+RD_SweepAndPrune::flush_removes
+
+One pass over the pairs and the endpoints,
+however many proxies were removed.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::flush_removes()
+{
+	for ( auto it = overlapping.begin(); it != overlapping.end(); ) {
+		int p = int( *it >> 32 );
+		int q = int( *it & 0xFFFFFFFF );
+		if ( proxies[p].live && proxies[q].live ) ++it;
+		else {
+			event_log.push_back( std::make_pair( *it, false ) );
+			it = overlapping.erase( it );
+		}
+	}
+
+	// Proxies that were never sorted in have no endpoints
+	for ( int axis = 0; axis < 2; ++axis ) {
+		std::vector < Endpoint >& es = axes[ axis ];
+		es.erase( std::remove_if( es.begin(), es.end(),
+			[this]( const Endpoint& e ) { return ! proxies[ e.proxy ].live; } ),
+			es.end() );
+		reindex( axis );
+	}
+
+	free_list.insert( free_list.end(), removed.begin(), removed.end() );
+	removed.clear();
+}
+
+/*
+================================
+RD_SweepAndPrune::flush_inserts
+
+Appends the new endpoints, sorts them and merges them in,
+then sweeps the x axis once (checking y by endpoint order)
+to find every pair with a new proxy in it.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::flush_inserts()
+{
+	for ( int axis = 0; axis < 2; ++axis ) {
+		std::vector < Endpoint >& es = axes[ axis ];
+		int old_size = es.size();
+
+		for ( int id : inserted ) {
+			// Removed before it was ever sorted in
+			if ( ! proxies[ id ].live ) continue;
+
+			const AABB& box = proxies[ id ].box;
+			Endpoint lo = { box.min[ axis ], id, false };
+			Endpoint hi = { max_value( box, axis ), id, true };
+			es.push_back( lo );
+			es.push_back( hi );
+		}
+
+		std::sort( es.begin() + old_size, es.end() );
+		std::inplace_merge( es.begin(), es.begin() + old_size, es.end() );
+		reindex( axis );
+	}
+
+	// Proxies whose min endpoint has been passed, but not their max
+	std::vector < int > active;
+	std::vector < int > slot( proxies.size() );
+
+	for ( const Endpoint& e : axes[0] ) {
+		if ( e.max ) {
+			int last = active.back();
+			active[ slot[ e.proxy ] ] = last;
+			slot[ last ] = slot[ e.proxy ];
+			active.pop_back();
+			continue;
+		}
+
+		bool fresh = proxies[ e.proxy ].fresh;
+		for ( int q : active ) {
+			if ( ( fresh || proxies[q].fresh ) && overlaps( 1, e.proxy, q ) ) {
+				add_pair( e.proxy, q );
+			}
+		}
+		slot[ e.proxy ] = active.size();
+		active.push_back( e.proxy );
+	}
+
+	for ( int id : inserted ) {
+		proxies[ id ].fresh = false;
+	}
+	inserted.clear();
+}
+
+/*
+================================
+RD_SweepAndPrune::reindex
+
+Points every proxy at its endpoints on the specified axis.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::reindex( int axis )
+{
+	const std::vector < Endpoint >& es = axes[ axis ];
+	int n = es.size();
+	for ( int i = 0; i < n; ++i ) {
+		Proxy& p = proxies[ es[i].proxy ];
+		if ( es[i].max ) p.max[ axis ] = i;
+		else p.min[ axis ] = i;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::measure
+
+Sets reach to twice the median length of the proxies on x,
+and lists the proxies longer than that (see query).
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::measure()
+{
+	const std::vector < Endpoint >& es = axes[0];
+	std::vector < Scalar > lengths;
+	lengths.reserve( es.size() / 2 );
+	for ( const Endpoint& e : es ) {
+		if ( e.max ) continue;
+		const Proxy& p = proxies[ e.proxy ];
+		lengths.push_back( es[ p.max[0] ].value - e.value );
+	}
+
+	reach = 0;
+	if ( ! lengths.empty() ) {
+		auto median = lengths.begin() + lengths.size() / 2;
+		std::nth_element( lengths.begin(), median, lengths.end() );
+		reach = *median * 2;
+	}
+
+	big_proxies.clear();
+	for ( const Endpoint& e : es ) {
+		if ( e.max ) continue;
+		Proxy& p = proxies[ e.proxy ];
+		p.big = es[ p.max[0] ].value - e.value > reach;
+		if ( p.big ) big_proxies.push_back( e.proxy );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::query (overloaded)
+
+Returns the results in a new vector.
+================================
+*/
+template < typename T >
+std::vector < T > RD_SweepAndPrune < T >::query( const AABB& box ) const
+{
+	std::vector < T > ts;
+	query( box, ts );
+	return ts;
+}
+
+/*
+================================
+RD_SweepAndPrune::query (overloaded)
+
+Fills the specified buffer with the results
+(the buffer keeps its storage between queries).
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::query( const AABB& box, std::vector < T >& out ) const
+{
+	out.clear();
+	query( box, [&out]( const T& t ) { out.push_back( t ); } );
+}
+
+/*
+================================
+RD_SweepAndPrune::query (overloaded)
+
+Calls visit( t ) for each result, without allocating.
+
+A proxy that isn't big starts at most reach to the left
+of any box it intersects, so only the x endpoints from there
+to the right side of the box are visited (found by binary search).
+Big proxies, and proxies not sorted in yet, are checked one by one.
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_SweepAndPrune < T >::query( const AABB& box, F&& visit ) const
+{
+	auto check = [&]( const Proxy& p ) {
+		if ( box.intersects( p.box ) ) visit( p.t );
+	};
+
+	for ( int id : inserted ) {
+		if ( proxies[ id ].live ) check( proxies[ id ] );
+	}
+	for ( int id : big_proxies ) {
+		const Proxy& p = proxies[ id ];
+		if ( p.live && p.big ) check( p );
+	}
+
+	// (one more unit on each side, for the slop and rounding)
+	Scalar lo = box.min[0] - reach - 1.0;
+	Scalar hi = max_value( box, 0 ) + 1.0;
+
+	const std::vector < Endpoint >& es = axes[0];
+	auto first = std::lower_bound( es.begin(), es.end(), lo,
+		[]( const Endpoint& e, Scalar x ) { return e.value < x; } );
+	for ( auto e = first; e != es.end() && e->value <= hi; ++e ) {
+		if ( e->max ) continue;
+		const Proxy& p = proxies[ e->proxy ];
+		if ( p.live && ! p.big ) check( p );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::operator []
+
+Returns the data stored with the specified proxy.
+================================
+*/
+template < typename T >
+T& RD_SweepAndPrune < T >::operator [] ( int proxy )
+{
+	return proxies[ proxy ].t;
+}
+
+/*
+================================
+RD_SweepAndPrune::pairs (overloaded)
+
+Returns all overlapping pairs (in no particular order).
+================================
+*/
+template < typename T >
+std::vector < typename RD_SweepAndPrune < T >::Pair >
+RD_SweepAndPrune < T >::pairs()
+{
+	std::vector < Pair > ret;
+	pairs( ret );
+	return ret;
+}
+
+/*
+================================
+RD_SweepAndPrune::pairs (overloaded)
+
+Fills the specified buffer with all overlapping pairs
+(the buffer keeps its storage between calls).
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::pairs( std::vector < Pair >& out )
+{
+	flush();
+	out.clear();
+	out.reserve( overlapping.size() );
+	pairs( [&out]( int p, int q ) { out.push_back( Pair( p, q ) ); } );
+}
+
+/*
+================================
+RD_SweepAndPrune::pairs (overloaded)
+
+Calls visit( lo, hi ) for each overlapping pair, without allocating.
+================================
+*/
+template < typename T >
+template < typename F >
+void RD_SweepAndPrune < T >::pairs( F&& visit )
+{
+	flush();
+	for ( unsigned long long key : overlapping ) {
+		visit( int( key >> 32 ), int( key & 0xFFFFFFFF ) );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::events
+
+Fills the specified buffers with the pairs that started
+and stopped overlapping since the last call (a pair that
+stopped and started again, or the other way around, isn't in either),
+ordered by ( lo, hi ), and forgets them.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::events( std::vector < Pair >& added, std::vector < Pair >& removed )
+{
+	flush();
+	added.clear();
+	removed.clear();
+
+	// (stable, so each pair's first event comes first)
+	std::stable_sort( event_log.begin(), event_log.end(),
+		[]( const std::pair < unsigned long long, bool >& a,
+			const std::pair < unsigned long long, bool >& b ) { return a.first < b.first; } );
+
+	int n = event_log.size();
+	for ( int i = 0; i < n; ) {
+		unsigned long long key = event_log[i].first;
+		// Overlapping before the first event, and now
+		bool before = ! event_log[i].second;
+		bool after = overlapping.count( key ) != 0;
+		while ( i < n && event_log[i].first == key ) ++i;
+
+		Pair pair( int( key >> 32 ), int( key & 0xFFFFFFFF ) );
+		if ( after && ! before ) added.push_back( pair );
+		if ( before && ! after ) removed.push_back( pair );
+	}
+
+	event_log.clear();
+}
+
+/*
+================================
+RD_SweepAndPrune::sort_min_down
+
+A min endpoint passing a max endpoint starts an overlap on this axis.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::sort_min_down( int axis, int e )
+{
+	std::vector < Endpoint >& es = axes[ axis ];
+
+	while ( e > 0 && es[e] < es[ e-1 ] ) {
+		const Endpoint& prev = es[ e-1 ];
+		if ( prev.max && overlaps( 1-axis, es[e].proxy, prev.proxy ) ) {
+			add_pair( es[e].proxy, prev.proxy );
+		}
+		swap( axis, e-1, e );
+		--e;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::sort_min_up
+
+A min endpoint passing a max endpoint ends an overlap on this axis.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::sort_min_up( int axis, int e )
+{
+	std::vector < Endpoint >& es = axes[ axis ];
+	int n = es.size();
+
+	while ( e+1 < n && es[ e+1 ] < es[e] ) {
+		const Endpoint& next = es[ e+1 ];
+		if ( next.max ) {
+			remove_pair( es[e].proxy, next.proxy );
+		}
+		swap( axis, e, e+1 );
+		++e;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::sort_max_down
+
+A max endpoint passing a min endpoint ends an overlap on this axis.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::sort_max_down( int axis, int e )
+{
+	std::vector < Endpoint >& es = axes[ axis ];
+
+	while ( e > 0 && es[e] < es[ e-1 ] ) {
+		const Endpoint& prev = es[ e-1 ];
+		if ( ! prev.max ) {
+			remove_pair( es[e].proxy, prev.proxy );
+		}
+		swap( axis, e-1, e );
+		--e;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::sort_max_up
+
+A max endpoint passing a min endpoint starts an overlap on this axis.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::sort_max_up( int axis, int e )
+{
+	std::vector < Endpoint >& es = axes[ axis ];
+	int n = es.size();
+
+	while ( e+1 < n && es[ e+1 ] < es[e] ) {
+		const Endpoint& next = es[ e+1 ];
+		if ( ! next.max && overlaps( 1-axis, es[e].proxy, next.proxy ) ) {
+			add_pair( es[e].proxy, next.proxy );
+		}
+		swap( axis, e, e+1 );
+		++e;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::swap
+
+Swaps two adjacent endpoints and fixes their proxies' indices.
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::swap( int axis, int e, int f )
+{
+	std::vector < Endpoint >& es = axes[ axis ];
+	std::swap( es[e], es[f] );
+
+	for ( int i : { e, f } ) {
+		Proxy& p = proxies[ es[i].proxy ];
+		if ( es[i].max ) p.max[ axis ] = i;
+		else p.min[ axis ] = i;
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::overlaps
+
+Returns true if the specified proxies overlap on the specified axis
+(according to endpoint order).
+================================
+*/
+template < typename T >
+bool RD_SweepAndPrune < T >::overlaps( int axis, int p, int q ) const
+{
+	const Proxy& a = proxies[p];
+	const Proxy& b = proxies[q];
+	return ( a.min[ axis ] < b.max[ axis ] ) && ( b.min[ axis ] < a.max[ axis ] );
+}
+
+/*
+================================
+RD_SweepAndPrune::max_value
+
+Returns the value stored for a max endpoint:
+AABB::intersects allows the same slop.
+================================
+*/
+template < typename T >
+Scalar RD_SweepAndPrune < T >::max_value( const AABB& box, int axis )
+{
+	return box.max[ axis ] + 1.0;
+}
+
+/*
+================================
+RD_SweepAndPrune::add_pair
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::add_pair( int p, int q )
+{
+	if ( p == q ) return;
+	unsigned long long key = pair_key( p, q );
+	if ( overlapping.insert( key ).second ) {
+		event_log.push_back( std::make_pair( key, true ) );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::remove_pair
+================================
+*/
+template < typename T >
+void RD_SweepAndPrune < T >::remove_pair( int p, int q )
+{
+	if ( p == q ) return;
+	unsigned long long key = pair_key( p, q );
+	if ( overlapping.erase( key ) ) {
+		event_log.push_back( std::make_pair( key, false ) );
+	}
+}
+
+/*
+================================
+RD_SweepAndPrune::pair_key
+================================
+*/
+template < typename T >
+unsigned long long RD_SweepAndPrune < T >::pair_key( int p, int q )
+{
+	unsigned long long lo = std::min( p, q );
+	unsigned long long hi = std::max( p, q );
+	return ( lo << 32 ) | hi;
+}
+
+#endif
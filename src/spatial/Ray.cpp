@@ -19,6 +19,19 @@ Ray::Ray( const Vec2& o, const Vec2& d ) :
 Ray::intersects (overloaded)
 
 Returns true if this ray intersects the specified AABB.
+================================
+*/
+bool Ray::intersects( const AABB& box ) const
+{
+	return intersects( box, SCALAR_MAX );
+}
+
+/*
+================================
+Ray::intersects (overloaded)
+
+Returns true if the part of this ray with t in [ 0, t_max ]
+intersects the specified AABB.
 
 This is the "slabs" method developed by Kay and Kayjia:
 http://www.siggraph.org/education/materials/HyperGraph/raytrace/rtinter3.htm
@@ -26,31 +39,31 @@ http://www.siggraph.org/education/materials/HyperGraph/raytrace/rtinter3.htm
 A slab is the space between two axis-aligned hyperplanes;
 an AABB is the intersection of [num_dimensions] slabs.
 We find t_near and t_far for each slab; the ray intersects the box iff
-the overall largest t_near is greater than the overall smallest t_far.
+the overall largest t_near is no greater than the overall smallest t_far.
 
-TODO: not robust for parallel case
+A ray parallel to a slab misses it unless its origin is inside the slab.
 ================================
 */
-bool Ray::intersects( const AABB& box ) const
+bool Ray::intersects( const AABB& box, Scalar t_max ) const
 {
-	if ( box.contains( origin ) )
-		return true;
-
-	if ( direction.x == 0 || direction.y == 0 )
-		return false;
-
-	Scalar t_near = -SCALAR_MAX;
-	Scalar t_far = SCALAR_MAX;
+	Scalar t_near = 0;
+	Scalar t_far = t_max;
 
 	for ( int i = 0; i < 2; ++i ) {
+		if ( direction[i] == 0 ) {
+			if ( origin[i] < box.min[i] || origin[i] > box.max[i] ) return false;
+			continue;
+		}
+
 		Scalar t1 = ( box.min[i] - origin[i] ) / direction[i];
 		Scalar t2 = ( box.max[i] - origin[i] ) / direction[i];
-		if ( t1 < t2 ) std::swap( t1, t2 );
+		if ( t1 > t2 ) std::swap( t1, t2 );
 		t_near = std::max( t_near, t1 );
-		t_far = std::max( t_far, t2 );
+		t_far = std::min( t_far, t2 );
+		if ( t_near > t_far ) return false;
 	}
 
-	return ( t_near > t_far );
+	return true;
 }
 
 /*
@@ -23,6 +23,7 @@ public: // Lifecycle
 
 public: // Collision
 	bool intersects( const AABB& box ) const;
+	bool intersects( const AABB& box, Scalar t_max ) const;
 	std::pair < bool, Scalar > intersects( const Ray& ray ) const;
 	std::pair < bool, Scalar > intersects( const Segment& seg ) const;
 
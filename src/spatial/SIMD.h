@@ -0,0 +1,36 @@
+#ifndef SPATIAL_SIMD_H
+#define SPATIAL_SIMD_H
+
+#include "Scalar.h" // for SCALAR_USE_DOUBLE_PRECISION
+
+/*
+================================
+SIMD instruction set selection.
+
+Defines SPATIAL_SIMD_AVX (8 floats per instruction)
+or SPATIAL_SIMD_SSE (4 floats per instruction)
+depending on the compiler's target, and SPATIAL_SIMD_LANES.
+
+Vector code is only used with single precision Scalars;
+define SPATIAL_NO_SIMD to force the scalar code everywhere.
+================================
+*/
+#if !defined( SPATIAL_NO_SIMD ) && !defined( SCALAR_USE_DOUBLE_PRECISION )
+	#if defined( __AVX__ )
+		#define SPATIAL_SIMD_AVX
+		#include <immintrin.h>
+	#elif defined( __SSE__ ) || defined( _M_X64 )
+		#define SPATIAL_SIMD_SSE
+		#include <xmmintrin.h>
+	#endif
+#endif
+
+#if defined( SPATIAL_SIMD_AVX )
+	#define SPATIAL_SIMD_LANES 8
+#elif defined( SPATIAL_SIMD_SSE )
+	#define SPATIAL_SIMD_LANES 4
+#else
+	#define SPATIAL_SIMD_LANES 1
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef SPATIAL_SMALL_VECTOR_H
+#define SPATIAL_SMALL_VECTOR_H
+
+#include <vector>
+
+/*
+================================
+SmallVector
+
+A vector that keeps up to N elements inline,
+and only moves them to the heap when it grows past N.
+
+Copying a SmallVector with at most N elements doesn't allocate.
+
+Only for plain value types (like Vec2 and Scalar):
+all N inline elements are always value-initialized.
+================================
+*/
+template < typename T, int N >
+class SmallVector
+{
+public:
+	SmallVector() : inline_ts(), n( 0 ) {}
+
+	template < typename It >
+	SmallVector( It first, It last ) : inline_ts(), n( 0 ) { assign( first, last ); }
+
+	template < typename It >
+	void assign( It first, It last );
+
+	int size() const { return n; }
+	bool empty() const { return n == 0; }
+
+	void clear();
+	void resize( int size );
+	void push_back( const T& t );
+
+	T* data() { return n <= N ? inline_ts : &heap_ts[0]; }
+	const T* data() const { return n <= N ? inline_ts : &heap_ts[0]; }
+
+	T& operator [] ( int i ) { return data()[i]; }
+	const T& operator [] ( int i ) const { return data()[i]; }
+
+	T* begin() { return data(); }
+	T* end() { return data() + n; }
+	const T* begin() const { return data(); }
+	const T* end() const { return data() + n; }
+
+private: // Members
+	T inline_ts[ N ];
+	std::vector < T > heap_ts; // all elements, once there are more than N
+	int n;
+};
+
+/*
+================================
+SmallVector::assign
+================================
+*/
+template < typename T, int N >
+template < typename It >
+void SmallVector < T, N >::assign( It first, It last )
+{
+	clear();
+	for ( ; first != last; ++first ) {
+		push_back( *first );
+	}
+}
+
+/*
+================================
+SmallVector::clear
+
+Keeps heap storage, if any.
+================================
+*/
+template < typename T, int N >
+void SmallVector < T, N >::clear()
+{
+	heap_ts.clear();
+	n = 0;
+}
+
+/*
+================================
+SmallVector::resize
+
+New elements are value-initialized.
+================================
+*/
+template < typename T, int N >
+void SmallVector < T, N >::resize( int size )
+{
+	if ( size <= N ) {
+		// Move back inline
+		if ( n > N ) {
+			for ( int i = 0; i < size; ++i ) {
+				inline_ts[i] = heap_ts[i];
+			}
+			heap_ts.clear();
+		}
+		for ( int i = n; i < size; ++i ) {
+			inline_ts[i] = T();
+		}
+	}
+	else {
+		// Move to the heap
+		if ( n <= N ) {
+			heap_ts.assign( inline_ts, inline_ts + n );
+		}
+		heap_ts.resize( size );
+	}
+	n = size;
+}
+
+/*
+================================
+SmallVector::push_back
+================================
+*/
+template < typename T, int N >
+void SmallVector < T, N >::push_back( const T& t )
+{
+	if ( n < N ) {
+		inline_ts[ n ] = t;
+	}
+	else {
+		// Move to the heap
+		if ( n == N ) {
+			heap_ts.assign( inline_ts, inline_ts + N );
+		}
+		heap_ts.push_back( t );
+	}
+	++n;
+}
+
+#endif
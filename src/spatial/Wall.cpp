@@ -1,5 +1,7 @@
 #include "Wall.h"
 #include "Convex.h"
+#include "SIMD.h" // for Wall::distance
+#include <cassert>
 
 /*
 ================================
@@ -74,17 +76,61 @@ Scalar Wall::shadow( const Vec2& p ) const
 /*
 ================================
 Wall::distance
+
+Returns the minimum distance from this plane to the points of the specified polygon.
+
+Projects SPATIAL_SIMD_LANES points at once, from the polygon's
+structure of arrays (with the same arithmetic as the point version).
+This is the inner loop of Convex::sat.
 ================================
 */
-Scalar Wall::distance( const Convex& c ) const
+Scalar Wall::distance( const ConvexView& c ) const
 {
+	assert( c.xs.size() >= c.points.size() );
+	int n = c.xs.size();
+
+#if defined( SPATIAL_SIMD_AVX )
+	const __m256 ox = _mm256_set1_ps( origin.x ), oy = _mm256_set1_ps( origin.y );
+	const __m256 nx = _mm256_set1_ps( normal.x ), ny = _mm256_set1_ps( normal.y );
+
+	__m256 min = _mm256_set1_ps( SCALAR_MAX );
+	for ( int i = 0; i < n; i += 8 ) {
+		__m256 dx = _mm256_sub_ps( _mm256_loadu_ps( &c.xs[i] ), ox );
+		__m256 dy = _mm256_sub_ps( _mm256_loadu_ps( &c.ys[i] ), oy );
+		__m256 d = _mm256_add_ps( _mm256_mul_ps( dx, nx ), _mm256_mul_ps( dy, ny ) );
+		min = _mm256_min_ps( min, d );
+	}
+
+	// Horizontal minimum
+	__m128 m = _mm_min_ps( _mm256_castps256_ps128( min ), _mm256_extractf128_ps( min, 1 ) );
+	m = _mm_min_ps( m, _mm_movehl_ps( m, m ) );
+	m = _mm_min_ss( m, _mm_shuffle_ps( m, m, 1 ) );
+	return _mm_cvtss_f32( m );
+#elif defined( SPATIAL_SIMD_SSE )
+	const __m128 ox = _mm_set1_ps( origin.x ), oy = _mm_set1_ps( origin.y );
+	const __m128 nx = _mm_set1_ps( normal.x ), ny = _mm_set1_ps( normal.y );
+
+	__m128 min = _mm_set1_ps( SCALAR_MAX );
+	for ( int i = 0; i < n; i += 4 ) {
+		__m128 dx = _mm_sub_ps( _mm_loadu_ps( &c.xs[i] ), ox );
+		__m128 dy = _mm_sub_ps( _mm_loadu_ps( &c.ys[i] ), oy );
+		__m128 d = _mm_add_ps( _mm_mul_ps( dx, nx ), _mm_mul_ps( dy, ny ) );
+		min = _mm_min_ps( min, d );
+	}
+
+	// Horizontal minimum
+	min = _mm_min_ps( min, _mm_movehl_ps( min, min ) );
+	min = _mm_min_ss( min, _mm_shuffle_ps( min, min, 1 ) );
+	return _mm_cvtss_f32( min );
+#else
 	Scalar min = SCALAR_MAX;
 
-	for ( const Vec2& p : c.points ) {
-		min = std::min( min, distance( p ) );
+	for ( int i = 0; i < n; ++i ) {
+		min = std::min( min, distance( Vec2( c.xs[i], c.ys[i] ) ) );
 	}
 
 	return min;
+#endif
 }
 
 /*
@@ -92,7 +138,7 @@ Scalar Wall::distance( const Convex& c ) const
 Wall::contains
 ================================
 */
-bool Wall::contains( const Convex& c ) const
+bool Wall::contains( const ConvexView& c ) const
 {
 	return distance( c ) < 0;
 }
@@ -102,7 +148,7 @@ bool Wall::contains( const Convex& c ) const
 Wall::shadow
 ================================
 */
-std::pair < Scalar, Scalar > Wall::shadow( const Convex& c ) const
+std::pair < Scalar, Scalar > Wall::shadow( const ConvexView& c ) const
 {
 	Scalar min = SCALAR_MAX;
 	Scalar max = -SCALAR_MAX;
@@ -4,7 +4,7 @@
 #include "Vec2.h"
 
 // Shadow
-struct Convex;
+struct ConvexView;
 
 /*
 ================================
@@ -29,9 +29,9 @@ public: // Point
 	Scalar shadow( const Vec2& p ) const;
 
 public: // Convex
-	Scalar distance( const Convex& c ) const;
-	bool contains( const Convex& c ) const;
-	std::pair < Scalar, Scalar > shadow( const Convex& c ) const;
+	Scalar distance( const ConvexView& c ) const;
+	bool contains( const ConvexView& c ) const;
+	std::pair < Scalar, Scalar > shadow( const ConvexView& c ) const;
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "ColumnTestState.h"
 #include <vector>
+#include <thread> // for hardware_concurrency
 
 /*
 ================================
@@ -22,6 +23,8 @@ ColumnTestState::init
 void ColumnTestState::init( Engine* game )
 {
 	EntityState::init( game );
+	setSolverThreads( std::thread::hardware_concurrency() );
+	setBroadPhase( BP_SWEEP_AND_PRUNE );
 
 	const int x = 10;
 	const Scalar scale = 50.0;